@@ -0,0 +1,212 @@
+/**
+ * ========================
+ * File: arena.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Static arenas for the
+ * memories on the board. Each
+ * region has a budget and hands
+ * out memory from the bottom up,
+ * nothing is freed except by
+ * rewinding to a mark. Effects
+ * and the engine take their
+ * state, lines and buffers from
+ * here at boot, and a report of
+ * what each region has used is
+ * printed once they're made.
+ *
+ * On the host each region is
+ * malloc'd at the same size.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * @brief A region and what's been taken from it
+ */
+typedef struct
+{
+	const char* name;
+	uint8_t* base;
+	uint32_t size;
+	uint32_t used;
+	uint32_t allocs;
+	uint32_t failed;
+}Arena;
+
+#ifndef HOST_SIM
+// DTCM and SRAM1 are placed by the linker script,
+// SDRAM starts after the LCD frame buffer
+static AUDIO_DTCM uint8_t arena_dtcm[ARENA_DTCM_SIZE] __attribute__((aligned(ARENA_ALIGN_CACHE)));
+static uint8_t arena_sram1[ARENA_SRAM1_SIZE] __attribute__((aligned(ARENA_ALIGN_CACHE)));
+#define ARENA_SDRAM_ADDR (LCD_FRAME_BUFFER + LCD_FRAME_BUFFER_BYTES)
+#endif
+
+static Arena arenas[ARENA_REGION_NUM] =
+{
+	[ARENA_DTCM]  = {"DTCM",  NULL, ARENA_DTCM_SIZE},
+	[ARENA_SRAM1] = {"SRAM1", NULL, ARENA_SRAM1_SIZE},
+	[ARENA_SDRAM] = {"SDRAM", NULL, ARENA_SDRAM_SIZE},
+};
+
+/**
+ * @brief Set up the regions, empty. Call
+ *        before anything is allocated.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void arena_init(void)
+{
+#ifdef HOST_SIM
+	// only malloc once, a second init just empties them
+	for(int i = 0; i < ARENA_REGION_NUM; i++)
+		if(arenas[i].base == NULL)
+			arenas[i].base = aligned_alloc(ARENA_ALIGN_CACHE, arenas[i].size);
+#else
+	arenas[ARENA_DTCM].base = arena_dtcm;
+	arenas[ARENA_SRAM1].base = arena_sram1;
+	arenas[ARENA_SDRAM].base = (uint8_t*)ARENA_SDRAM_ADDR;
+#endif
+
+	for(int i = 0; i < ARENA_REGION_NUM; i++)
+	{
+		arenas[i].used = 0;
+		arenas[i].allocs = 0;
+		arenas[i].failed = 0;
+	}
+}
+
+/**
+ * @brief Take memory from a region, it is
+ *        zeroed and only given back by
+ *        arena_rewind().
+ *
+ * @param region Region to take it from
+ * @param bytes Number of bytes
+ * @param align Alignment, a power of 2
+ *
+ * @retval The memory, NULL if it's over
+ *         the regions budget
+ */
+void* arena_alloc(ArenaRegion region, uint32_t bytes, uint32_t align)
+{
+	if(region >= ARENA_REGION_NUM)
+		return NULL;
+
+	Arena* arena = &arenas[region];
+
+	if(align < ARENA_ALIGN)
+		align = ARENA_ALIGN;
+
+	// pad up to the alignment, the base is
+	// cache line aligned so offsets will do
+	uint32_t start = (arena->used + align - 1) & ~(align - 1);
+
+	if(arena->base == NULL || start > arena->size || bytes > arena->size - start)
+	{
+		arena->failed++;
+		return NULL;
+	}
+
+	uint8_t* memory = arena->base + start;
+	memset(memory, 0, bytes);
+
+	arena->used = start + bytes;
+	arena->allocs++;
+
+	return memory;
+}
+
+/**
+ * @brief Note where each region is up to.
+ *
+ * @param mark Where to put it
+ *
+ * @retval None
+ */
+void arena_mark(ArenaMark* mark)
+{
+	for(int i = 0; i < ARENA_REGION_NUM; i++)
+	{
+		mark->used[i] = arenas[i].used;
+		mark->allocs[i] = arenas[i].allocs;
+	}
+}
+
+/**
+ * @brief Give back everything taken since a
+ *        mark, for when only part of a set of
+ *        allocations fit. Failed counts stay so
+ *        the report still shows them.
+ *
+ * @param mark Mark from arena_mark()
+ *
+ * @retval None
+ */
+void arena_rewind(const ArenaMark* mark)
+{
+	// everything is taken bottom up, so going
+	// back to the mark frees only what came after
+	for(int i = 0; i < ARENA_REGION_NUM; i++)
+	{
+		arenas[i].used = mark->used[i];
+		arenas[i].allocs = mark->allocs[i];
+	}
+}
+
+/**
+ * @brief Get how much of a region is used.
+ *
+ * @param region The region
+ * @param usage Where to put it
+ *
+ * @retval None
+ */
+void arena_getUsage(ArenaRegion region, ArenaUsage* usage)
+{
+	const Arena* arena = &arenas[region];
+
+	usage->name = arena->name;
+	usage->size = arena->size;
+	usage->used = arena->used;
+	usage->allocs = arena->allocs;
+	usage->failed = arena->failed;
+}
+
+/**
+ * @brief Print what each region has used
+ *        against its budget.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void arena_report(void)
+{
+	printf("memory budget\r\n");
+
+	for(int i = 0; i < ARENA_REGION_NUM; i++)
+	{
+		const Arena* arena = &arenas[i];
+
+		printf("  %-5s %8lu / %8lu bytes %3lu%% %2lu allocs",
+				arena->name,
+				(unsigned long)arena->used,
+				(unsigned long)arena->size,
+				(unsigned long)(arena->used * 100ull / arena->size),
+				(unsigned long)arena->allocs);
+
+		if(arena->failed)
+			printf(" %lu OVER BUDGET", (unsigned long)arena->failed);
+
+		printf("\r\n");
+	}
+}
@@ -0,0 +1,154 @@
+/**
+ * ========================
+ * File: arena.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Static arenas for the
+ * memories on the board. Each
+ * region has a budget and hands
+ * out memory from the bottom up,
+ * nothing is freed except by
+ * rewinding to a mark. Effects
+ * and the engine take their
+ * state, lines and buffers from
+ * here at boot, and a report of
+ * what each region has used is
+ * printed once they're made.
+ *
+ * Where an effect puts things:
+ * the state its kernel works on
+ * in DTCM, next to the kernels,
+ * the parameter values the UI
+ * writes in SRAM1, and its line
+ * in whichever region it fits,
+ * short lines in SRAM1 and long
+ * ones in SDRAM. The line is
+ * taken first, it's the biggest
+ * so the most likely not to fit,
+ * and nothing else is taken if
+ * it doesn't.
+ *
+ * On the host each region is
+ * malloc'd at the same size.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include "main.h"
+
+/**
+ * @brief Memories to allocate from,
+ *        fastest first
+ */
+typedef enum
+{
+	ARENA_DTCM = 0,  // zero wait state, kernel state and blocks
+	ARENA_SRAM1,     // cached, short lines and parameter values
+	ARENA_SDRAM,     // external, DMA buffers and long lines
+	ARENA_REGION_NUM
+}ArenaRegion;
+
+// budget for each region in bytes
+#define ARENA_DTCM_SIZE  ((uint32_t)(32*1024))
+#define ARENA_SRAM1_SIZE ((uint32_t)(96*1024))
+#define ARENA_SDRAM_SIZE ((uint32_t)(6*1024*1024))
+
+// alignment when nothing else is asked for,
+// and for anything a DMA or the cache touches
+#define ARENA_ALIGN       8
+#define ARENA_ALIGN_CACHE 32
+
+/**
+ * @brief How much of a region is used
+ */
+typedef struct
+{
+	const char* name;
+	uint32_t size;     // budget
+	uint32_t used;     // including alignment padding
+	uint32_t allocs;   // allocations made
+	uint32_t failed;   // allocations over budget
+}ArenaUsage;
+
+/**
+ * @brief Set up the regions, empty. Call
+ *        before anything is allocated.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void arena_init(void);
+
+/**
+ * @brief Take memory from a region, it is
+ *        zeroed and only given back by
+ *        arena_rewind().
+ *
+ * @param region Region to take it from
+ * @param bytes Number of bytes
+ * @param align Alignment, a power of 2
+ *
+ * @retval The memory, NULL if it's over
+ *         the regions budget
+ */
+void* arena_alloc(ArenaRegion region, uint32_t bytes, uint32_t align);
+
+/**
+ * @brief Where each region is up to, take one
+ *        before a set of allocations that should
+ *        all happen or none of them
+ */
+typedef struct
+{
+	uint32_t used[ARENA_REGION_NUM];
+	uint32_t allocs[ARENA_REGION_NUM];
+}ArenaMark;
+
+/**
+ * @brief Note where each region is up to.
+ *
+ * @param mark Where to put it
+ *
+ * @retval None
+ */
+void arena_mark(ArenaMark* mark);
+
+/**
+ * @brief Give back everything taken since a
+ *        mark, for when only part of a set of
+ *        allocations fit. Failed counts stay so
+ *        the report still shows them.
+ *
+ * @param mark Mark from arena_mark()
+ *
+ * @retval None
+ */
+void arena_rewind(const ArenaMark* mark);
+
+/**
+ * @brief Get how much of a region is used.
+ *
+ * @param region The region
+ * @param usage Where to put it
+ *
+ * @retval None
+ */
+void arena_getUsage(ArenaRegion region, ArenaUsage* usage);
+
+/**
+ * @brief Print what each region has used
+ *        against its budget.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void arena_report(void);
+
+#endif
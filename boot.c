@@ -0,0 +1,167 @@
+/**
+ * ========================
+ * File: boot.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Times each phase of
+ * boot off the cycle counter.
+ * The audio path comes up first,
+ * straight through, and the
+ * display, effects and UI after
+ * it, so the time from reset to
+ * the first block played is kept
+ * as a number of its own.
+ *
+ * On the host the cycle counter
+ * is the monotonic clock.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "boot.h"
+
+static const char* boot_names[BOOT_PHASE_NUM] =
+{
+	"clocks", "memory", "audio", "display", "effects", "ui"
+};
+
+// microseconds each phase took
+static uint32_t phase_us[BOOT_PHASE_NUM];
+
+// end of the last phase, in cycles and in
+// microseconds since boot_start(). the clock
+// changes during boot, so time is added up
+// a phase at a time at the clock it began on
+static uint32_t last_cycles;
+static uint32_t last_us;
+static uint32_t last_clock;
+
+static volatile uint32_t first_audio_us;
+
+/**
+ * @brief Time since boot_start(), counting
+ *        from the end of the last phase.
+ *
+ * @param now Cycle counter now
+ *
+ * @retval Microseconds
+ */
+static uint32_t boot_elapsed(uint32_t now)
+{
+	return last_us + (uint32_t)((now - last_cycles) / (last_clock / 1000000u));
+}
+
+/**
+ * @brief Start timing, as early in
+ *        main() as we can.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void boot_start(void)
+{
+	profile_init();
+
+	for(int i = 0; i < BOOT_PHASE_NUM; i++)
+		phase_us[i] = 0;
+
+	first_audio_us = 0;
+	last_us = 0;
+	last_clock = SystemCoreClock;
+	last_cycles = profile_cycles();
+}
+
+/**
+ * @brief Mark the end of a phase, it runs
+ *        from the end of the last one.
+ *
+ * @param phase The phase that's done
+ *
+ * @retval None
+ */
+void boot_mark(BootPhase phase)
+{
+	// the audio task may be reading these
+	__disable_irq();
+
+	uint32_t now = profile_cycles();
+	uint32_t us = boot_elapsed(now);
+
+	phase_us[phase] = us - last_us;
+	last_us = us;
+	last_cycles = now;
+	last_clock = SystemCoreClock;
+
+	__enable_irq();
+}
+
+/**
+ * @brief Mark the first block played, only
+ *        the first call counts. Safe to call
+ *        from the audio task.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void boot_firstAudio(void)
+{
+	__disable_irq();
+
+	if(first_audio_us == 0)
+		first_audio_us = boot_elapsed(profile_cycles());
+
+	__enable_irq();
+}
+
+/**
+ * @brief How long a phase took.
+ *
+ * @param phase The phase
+ *
+ * @retval Microseconds, 0 if it hasn't finished
+ */
+uint32_t boot_getPhase(BootPhase phase)
+{
+	return phase_us[phase];
+}
+
+/**
+ * @brief Time from boot_start() to the
+ *        first block played.
+ *
+ * @param None
+ *
+ * @retval Microseconds, 0 if none played yet
+ */
+uint32_t boot_getFirstAudio(void)
+{
+	return first_audio_us;
+}
+
+/**
+ * @brief Print how long each phase took
+ *        and the time to first audio.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void boot_report(void)
+{
+	uint32_t total = 0;
+
+	printf("boot\r\n");
+
+	for(int i = 0; i < BOOT_PHASE_NUM; i++)
+	{
+		total += phase_us[i];
+		printf("  %-8s %7lu us\r\n", boot_names[i], (unsigned long)phase_us[i]);
+	}
+
+	printf("  total    %7lu us\r\n", (unsigned long)total);
+	printf("  first audio at %lu us\r\n", (unsigned long)first_audio_us);
+}
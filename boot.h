@@ -0,0 +1,104 @@
+/**
+ * ========================
+ * File: boot.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Times each phase of
+ * boot off the cycle counter.
+ * The audio path comes up first,
+ * straight through, and the
+ * display, effects and UI after
+ * it, so the time from reset to
+ * the first block played is kept
+ * as a number of its own.
+ *
+ * On the host the cycle counter
+ * is the monotonic clock.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __BOOT_H
+#define __BOOT_H
+
+#include "main.h"
+#include "profile.h"
+
+/**
+ * @brief Phases of boot, in the order
+ *        main() runs them
+ */
+typedef enum
+{
+	BOOT_CLOCKS = 0, // HAL, the PLL and the UART
+	BOOT_MEMORY,     // SDRAM and the arenas
+	BOOT_AUDIO,      // codec streaming, straight through
+	BOOT_DISPLAY,    // LCD and touch screen
+	BOOT_EFFECTS,    // effects made and handed to the engine
+	BOOT_UI,         // main window drawn, tasks set
+	BOOT_PHASE_NUM
+}BootPhase;
+
+/**
+ * @brief Start timing, as early in
+ *        main() as we can.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void boot_start(void);
+
+/**
+ * @brief Mark the end of a phase, it runs
+ *        from the end of the last one.
+ *
+ * @param phase The phase that's done
+ *
+ * @retval None
+ */
+void boot_mark(BootPhase phase);
+
+/**
+ * @brief Mark the first block played, only
+ *        the first call counts. Safe to call
+ *        from the audio task.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void boot_firstAudio(void);
+
+/**
+ * @brief How long a phase took.
+ *
+ * @param phase The phase
+ *
+ * @retval Microseconds, 0 if it hasn't finished
+ */
+uint32_t boot_getPhase(BootPhase phase);
+
+/**
+ * @brief Time from boot_start() to the
+ *        first block played.
+ *
+ * @param None
+ *
+ * @retval Microseconds, 0 if none played yet
+ */
+uint32_t boot_getFirstAudio(void);
+
+/**
+ * @brief Print how long each phase took
+ *        and the time to first audio.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void boot_report(void);
+
+#endif
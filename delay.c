@@ -13,82 +13,189 @@
  * y(n) = x(n) + fb*x(n-delay)
  * ------------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
 #include "delay.h"
 
 // setup parameters
-static float parameterValues[2];
 static Parameter paramDepth = {"Feedback[%] ", 5.0f, 0.0f,  100.0f}; // 0 to 100 %
 static Parameter paramDelay = {"Delay[ms]   ",  50.0f, 0.0f,  1000.0f}; // 0 to 15ms
 static Parameter parameters[2];
-Effect delay;
 
 /**
  *
- * @brief This function intialized the global
- *        delay struct, this must be called 
- *        before usage.
+ * @brief Set up a new delay in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @param None
+ * @param effect The effect object to set up
  *
- * @retval None
+ * @retval 0 on success, -1 if an arena is out of budget
  *
  */
-void delay_init(void)
+int delay_create(Effect* effect)
 {
+	// a second of echoes at 96kHz, only SDRAM
+	// has room for it
+	frame_t* buffer = arena_alloc(ARENA_SDRAM, DELAY_LINE_SIZE*sizeof(frame_t), ARENA_ALIGN_CACHE);
+	if(buffer == NULL)
+		return -1;
+
+	// besides the line, just the length and
+	// feedback gain the kernel reads
+	DelayState* s = arena_alloc(ARENA_DTCM, sizeof(DelayState), ARENA_ALIGN);
+	float* values = arena_alloc(ARENA_SRAM1, 2*sizeof(float), ARENA_ALIGN);
+	if(s == NULL || values == NULL)
+		return -1;
+
 	// init params
 	parameters[0] = paramDepth;
 	parameters[1] = paramDelay;
 
-	parameterValues[0] = 50.0f;
-	parameterValues[1] = 500.0f;
+	values[0] = 50.0f;
+	values[1] = 500.0f;
+
+	// init state
+	s->params = effect->audioValues;
+	delayline_init(&s->line, buffer, DELAY_LINE_SIZE);
 
 	// init effect object
-	strcpy( delay.name, "Delay" );
-	delay.on = 0;
-	delay.currentParam = 0;
-	delay.paramNum = 2;
-	delay.parameters = parameters;
-	delay.processBuffer = delay_processBuffer;
-	delay.paramValues = parameterValues;
+	strcpy( effect->name, "Delay" );
+	effect->on = 0;
+	effect->currentParam = 0;
+	effect->paramNum = 2;
+	effect->parameters = parameters;
+	effect->prepare = delay_prepare;
+	effect->reset = delay_reset;
+	effect->tail = delay_tail;
+	effect->type = EFFECT_DELAY;
+	effect->processBuffer = delay_processBuffer;
+	effect->paramValues = values;
+	effect->state = s;
+
+	// audio loop picks these up before the first block
+	mailbox_init(&effect->mailbox);
+	effect_postParams(effect);
+
+	return 0;
+}
+
+/**
+ * @brief Work out the delay length and feedback
+ *        gain from the parameters. Called by the
+ *        engine when the parameters change.
+ *
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ *
+ * @retval None
+ *
+ */
+void delay_prepare(void* state, uint32_t sampleRate)
+{
+	DelayState* s = (DelayState*)state;
+
+	s->delaySamples = ((s->params[1])*sampleRate)/1000;
+
+	// line holds output up to the last
+	// sample, so 1 is as short as we go
+	if(s->delaySamples < 1)
+		s->delaySamples = 1;
+
+#if AUDIO_FIXED_POINT
+	s->feedbackGain = dsp_float_to_q15(s->params[0]/100.0f);
+#else
+	s->feedbackGain = (s->params[0]/100.0f);
+#endif
+}
+
+/**
+ * @brief Clear the line so the delay starts
+ *        from silence rather than the echoes
+ *        it held when it was turned off.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
+ *
+ * @retval None
+ *
+ */
+void delay_reset(void* state)
+{
+	DelayState* s = (DelayState*)state;
+
+	delayline_clear(&s->line);
+}
+
+/**
+ * @brief How far apart the echoes are, the
+ *        engine lets them ring out over this
+ *        after the delay is turned off.
+ *
+ * @param state The effects state
+ *
+ * @retval Delay length in frames
+ *
+ */
+uint32_t delay_tail(void* state)
+{
+	DelayState* s = (DelayState*)state;
+
+	return s->delaySamples;
 }
 
 /**
  * @brief This function applies the delay effect
  *        to the input buffer.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void delay_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset)
+AUDIO_ITCM void delay_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames)
 {
-	uint16_t delaySamples = ((parameterValues[1])*44100)/1000;
-	float feedbackGain = (parameterValues[0]/100.0f);
+	DelayState* s = (DelayState*)state;
+	uint32_t delaySamples = s->delaySamples;
+	sample_t feedbackGain = s->feedbackGain;
 
-	if(delay.on)
+#if AUDIO_FIXED_POINT
+	// same gain for both channels
+	frame_t feedback = dsp_pack(feedbackGain, feedbackGain);
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		// previous output frame with feedback gain
+		frame_t prevFrame = dsp_mul2(delayline_read(&s->line, delaySamples-1), feedback);
+
+		// mix frames together, saturating
+		outputData[i] = dsp_add2(inputData[i], prevFrame);
+
+		// output feeds back into the line
+		delayline_write(&s->line, outputData[i]);
+	}
+#else
+	for(uint32_t i = 0; i < frames; i++)
 	{
-		for(int i = offset; i < offset +(AUDIO_BLOCK_SIZE/2); i++)
-		{
-			// current sample
-			int16_t sample =  (int16_t)outputData[i];
+		// current frame
+		frame_t frame = inputData[i];
 
-			// previous sample
-			int16_t prevSample = (int16_t)outputData[(i + AUDIO_BUFFER_SIZE - delaySamples) % AUDIO_BUFFER_SIZE];
+		// previous output frame
+		frame_t prevFrame = delayline_read(&s->line, delaySamples-1);
 
-			// apply feedback gain
-			prevSample *= feedbackGain;
+		// mix frames together, with feedback gain
+		outputData[i].l = frame.l + prevFrame.l * feedbackGain;
+		outputData[i].r = frame.r + prevFrame.r * feedbackGain;
 
-			// mix samples together
-			outputData[i] = (uint16_t) (sample + prevSample);
-		}
+		// output feeds back into the line
+		delayline_write(&s->line, outputData[i]);
 	}
+#endif
 }
 
 
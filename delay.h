@@ -13,7 +13,7 @@
  * y(n) = x(n) + fb*x(n-delay)
  * ------------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -24,34 +24,90 @@
 #include "arm_math.h"
 #include "arm_common_tables.h"
 #include "effect.h"
+#include "delayline.h"
 
+// 1000ms at 96kHz, the fastest rate, rounded up
+// to a power of 2. 1MB as float frames, so each
+// delay takes its line from the SDRAM arena
+#define DELAY_LINE_SIZE ((uint32_t)131072)
 
-extern Effect delay; // global delay object
+/**
+ * @brief State for a delay,
+ *        the line holds previous output
+ */
+typedef struct
+{
+	const float* params;
+	DelayLine line;
+
+	// worked out by delay_prepare()
+	uint32_t delaySamples;
+	sample_t feedbackGain;
+}DelayState;
 
 /**
  *
- * @brief This function intialized the global
- *        delay struct, this must be called
- *        before usage.
+ * @brief Set up a new delay in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
+ *
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
+ *
+ */
+int delay_create(Effect* effect);
+
+/**
+ * @brief Work out the delay length and feedback
+ *        gain from the parameters. Called by the
+ *        engine when the parameters change.
+ *
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ *
+ * @retval None
+ *
+ */
+void delay_prepare(void* state, uint32_t sampleRate);
+
+/**
+ * @brief Clear the line so the delay starts
+ *        from silence rather than the echoes
+ *        it held when it was turned off.
+ *        Called before it is turned back on.
  *
- * @param None
+ * @param state The effects state
  *
  * @retval None
  *
  */
-void delay_init(void);
+void delay_reset(void* state);
+
+/**
+ * @brief How far apart the echoes are, the
+ *        engine lets them ring out over this
+ *        after the delay is turned off.
+ *
+ * @param state The effects state
+ *
+ * @retval Delay length in frames
+ *
+ */
+uint32_t delay_tail(void* state);
 
 /**
  * @brief This function applies the delay effect
  *        to the input buffer.
  * 
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void delay_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset);
+void delay_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames);
 
 #endif
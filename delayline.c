@@ -0,0 +1,52 @@
+/**
+ * ========================
+ * File: delayline.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: A delay line is a
+ * ring of previous frames an
+ * effect owns. Effects that
+ * need history (delay, flanger,
+ * vibrato) keep one in their
+ * state and go through this
+ * instead of indexing a global
+ * buffer. Size is a power of 2
+ * so wrapping is a mask, not
+ * a modulo.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "delayline.h"
+
+/**
+ * @brief Set up a delay line over a buffer
+ *        and clear it.
+ *
+ * @param line The delay line
+ * @param buffer Storage for the frames
+ * @param size Size of buffer in frames, power of 2
+ *
+ * @retval None
+ */
+void delayline_init(DelayLine* line, frame_t* buffer, uint32_t size)
+{
+	line->buffer = buffer;
+	line->mask = size - 1;
+	delayline_clear(line);
+}
+
+/**
+ * @brief Fill a delay line with silence.
+ *
+ * @param line The delay line
+ *
+ * @retval None
+ */
+void delayline_clear(DelayLine* line)
+{
+	memset(line->buffer, 0, (line->mask + 1) * sizeof(frame_t));
+	line->write = 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * ========================
+ * File: delayline.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: A delay line is a
+ * ring of previous frames an
+ * effect owns. Effects that
+ * need history (delay, flanger,
+ * vibrato) keep one in their
+ * state and go through this
+ * instead of indexing a global
+ * buffer. Size is a power of 2
+ * so wrapping is a mask, not
+ * a modulo.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __DELAYLINE_H
+#define __DELAYLINE_H
+
+#include "main.h"
+#include "dsp.h"
+#include "stdint.h"
+
+/**
+ * @brief Handle for a delay line,
+ *        set up with delayline_init()
+ */
+typedef struct
+{
+	frame_t* buffer;
+	uint32_t mask;  // size-1
+	uint32_t write; // where the next frame goes
+}DelayLine;
+
+/**
+ * @brief Set up a delay line over a buffer
+ *        and clear it.
+ *
+ * @param line The delay line
+ * @param buffer Storage for the frames
+ * @param size Size of buffer in frames, power of 2
+ *
+ * @retval None
+ */
+void delayline_init(DelayLine* line, frame_t* buffer, uint32_t size);
+
+/**
+ * @brief Fill a delay line with silence.
+ *
+ * @param line The delay line
+ *
+ * @retval None
+ */
+void delayline_clear(DelayLine* line);
+
+/**
+ * @brief Push a frame into the delay line.
+ *
+ * @param line The delay line
+ * @param frame Frame to push
+ *
+ * @retval None
+ */
+static inline void delayline_write(DelayLine* line, frame_t frame)
+{
+	line->buffer[line->write] = frame;
+	line->write = (line->write + 1) & line->mask;
+}
+
+/**
+ * @brief Read a previous frame.
+ *
+ * @param line The delay line
+ * @param delay How many frames back, 0 is
+ *        the last frame written. Must be
+ *        less than the size of the line.
+ *
+ * @retval The delayed frame
+ */
+static inline frame_t delayline_read(const DelayLine* line, uint32_t delay)
+{
+	return line->buffer[(line->write - 1 - delay) & line->mask];
+}
+
+#endif
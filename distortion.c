@@ -21,7 +21,7 @@
  *
  * ----------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -31,45 +31,94 @@
 // setup parameters
 #define DISTORTIONCLIPIDX 0
 #define DISTORTIONGAINIDX  1
-static float parameterValues[2];
 static Parameter paramClip  = {"Clipping[%]", 10.f, 0.0f, 100.f};
 static Parameter paramGain  = {"Gain[%]    ", 10.0f, 100.0f, 350.0f};
 static Parameter parameters[2];
-Effect distortion;
 
 // threshold_min - ( (0/100) * x)  = threshold_min
 // threshold_min - ( (100/100) * x)  = threshold_max
-static float clipping = 50.0f; // 50%
-static float gain = 150.0f;
-static const float clipping_coef = 20000.0f - 15000.0f;
+static const float clipping = 50.0f; // 50%
+static const float gain = 150.0f;
+static const float clipping_coef = (20000.0f - 15000.0f)/32768.0f;
 
 /*
  *
- * @brief This function intialized the global
- *        distortion struct, this must be
- *        called before usage.
+ * @brief Set up a new distortion in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @param None
- * @retval None
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
  *
  */
-void distortion_init(void)
+int distortion_create(Effect* effect)
 {
+	// only the gain and threshold, it has
+	// no history
+	DistortionState* s = arena_alloc(ARENA_DTCM, sizeof(DistortionState), ARENA_ALIGN);
+	float* values = arena_alloc(ARENA_SRAM1, 2*sizeof(float), ARENA_ALIGN);
+	if(s == NULL || values == NULL)
+		return -1;
+
 	// init params
 	parameters[DISTORTIONCLIPIDX] = paramClip;
 	parameters[DISTORTIONGAINIDX] = paramGain;
 
-	parameterValues[DISTORTIONCLIPIDX] = clipping;
-	parameterValues[DISTORTIONGAINIDX] = gain;
+	values[DISTORTIONCLIPIDX] = clipping;
+	values[DISTORTIONGAINIDX] = gain;
+
+	// init state
+	s->params = effect->audioValues;
 
 	// init effect object
-	strcpy( distortion.name, "DISTORTION" );
-	distortion.on = 0;
-	distortion.currentParam = 0;
-	distortion.paramNum = 2;
-	distortion.parameters = parameters;
-	distortion.processBuffer = distortion_processBuffer;
-	distortion.paramValues = parameterValues;
+	strcpy( effect->name, "DISTORTION" );
+	effect->on = 0;
+	effect->currentParam = 0;
+	effect->paramNum = 2;
+	effect->parameters = parameters;
+	effect->prepare = distortion_prepare;
+	effect->type = EFFECT_DISTORTION;
+	effect->processBuffer = distortion_processBuffer;
+	effect->paramValues = values;
+	effect->state = s;
+
+	// audio loop picks these up before the first block
+	mailbox_init(&effect->mailbox);
+	effect_postParams(effect);
+
+	return 0;
+}
+
+/*
+ *
+ * @brief Work out the gain and clipping threshold
+ *        from the parameters. Called by the engine
+ *        when the parameters change.
+ *
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ * @retval None
+ *
+ */
+void distortion_prepare(void* state, uint32_t sampleRate)
+{
+	DistortionState* s = (DistortionState*)state;
+	float gain = s->params[DISTORTIONGAINIDX]/100;
+	float clipping = s->params[DISTORTIONCLIPIDX];
+
+	// full scale is 1.0, so 10000/32768 at 0% clipping
+	float32_t threshold = (10000.0f/32768.0f) - ((clipping/100) * clipping_coef);
+
+#if AUDIO_FIXED_POINT
+	// gain goes up to 3.5 so it won't fit in Q15,
+	// hold it in Q12 and work in 32 bits
+	s->gain = (int32_t)(gain * 4096.0f);
+	s->threshold = (int32_t)(threshold * 32768.0f);
+#else
+	s->gain = gain;
+	s->threshold = threshold;
+#endif
 }
 
 /*
@@ -77,39 +126,19 @@ void distortion_init(void)
  * @brief This function will perfrom the distortion effect
  *        on the data passed in.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffer
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void distortion_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset)
+AUDIO_ITCM void distortion_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames)
 {
-	if(distortion.on)
-	{
-		gain = parameterValues[DISTORTIONGAINIDX]/100;
-		clipping = parameterValues[DISTORTIONCLIPIDX];
-
-		int16_t threshold = 10000.0f - ((clipping/100) * clipping_coef);
-
-		for(int i = offset; i < offset+(AUDIO_BLOCK_SIZE/2); i++)
-		{
-			// get current sample 
-			int16_t sample = (int16_t)outputData[i];
-
-			// apply input gain
-			sample *= gain;
-
-			// check if above threshold
-			if(fabsf(sample) >= threshold)
-			{
-				if(sample > 0) sample = threshold;
-				else sample = -threshold;
-			}
+	// copy so the gain and threshold stay in registers
+	const DistortionState s = *(const DistortionState*)state;
 
-			// send to output
-			outputData[i] = (uint16_t)sample;
-		}
-	}
+	for(uint32_t i = 0; i < frames; i++)
+		outputData[i] = distortion_frame(&s, inputData[i]);
 }
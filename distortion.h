@@ -7,8 +7,8 @@
  * Desc: The distortion effect,
  * this is where all the
  * function definitions are
- * located. And the global
- * distortion struct. Distortion is
+ * located. And the state
+ * for each distortion. Distortion is
  * when the input signal is distorted.
  * In this implementation we 
  * use HARD CLIPPING.
@@ -21,7 +21,7 @@
  * 
  * ----------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -34,33 +34,106 @@
 #include "arm_common_tables.h"
 #include "effect.h"
 
-// global distortion object
-extern Effect distortion; 
+/**
+ * @brief State for a distortion,
+ *        it is memoryless so just
+ *        the parameters
+ */
+typedef struct
+{
+	const float* params;
+
+	// worked out by distortion_prepare()
+#if AUDIO_FIXED_POINT
+	int32_t gain;      // Q12, it goes above 1
+	int32_t threshold; // Q15
+#else
+	float gain;
+	float threshold;
+#endif
+}DistortionState;
+
+/*
+ *
+ * @brief Set up a new distortion in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
+ *
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
+ *
+ */
+int distortion_create(Effect* effect);
 
 /*
  *
- * @brief This function intialized the global
- *        distortion struct, this must be 
- *        called before usage.
+ * @brief Work out the gain and clipping threshold
+ *        from the parameters. Called by the engine
+ *        when the parameters change.
  *
- * @param None
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
  * @retval None
  *
  */
-void distortion_init(void);
+void distortion_prepare(void* state, uint32_t sampleRate);
 
 /*
  *
  * @brief This function will perfrom the distortion effect
  *        on the data passed in.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffer
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void distortion_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset);
+void distortion_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames);
+
+/*
+ *
+ * @brief Distortion on one frame, the block kernel
+ *        and the fused kernels are built from this.
+ *
+ * @param s The effects state
+ * @param x The frame
+ *
+ * @retval The output frame
+ *
+ */
+static inline frame_t distortion_frame(const DistortionState* s, frame_t x)
+{
+#if AUDIO_FIXED_POINT
+	// apply input gain to both channels
+	int32_t left  = ((int32_t)dsp_left(x) * s->gain) >> 12;
+	int32_t right = ((int32_t)dsp_right(x) * s->gain) >> 12;
+
+	// hard clip at the threshold
+	if(left > s->threshold) left = s->threshold;
+	else if(left < -s->threshold) left = -s->threshold;
+	if(right > s->threshold) right = s->threshold;
+	else if(right < -s->threshold) right = -s->threshold;
+
+	return dsp_pack((q15_t)left, (q15_t)right);
+#else
+	// apply input gain to both channels
+	float32_t left  = x.l * s->gain;
+	float32_t right = x.r * s->gain;
+
+	// hard clip at the threshold
+	if(left > s->threshold) left = s->threshold;
+	else if(left < -s->threshold) left = -s->threshold;
+	if(right > s->threshold) right = s->threshold;
+	else if(right < -s->threshold) right = -s->threshold;
+
+	x.l = left;
+	x.r = right;
+	return x;
+#endif
+}
 
 #endif
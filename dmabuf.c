@@ -0,0 +1,49 @@
+/**
+ * ========================
+ * File: dmabuf.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Buffers the codec DMA
+ * reads and writes. The DMA
+ * doesn't go through the
+ * D-cache, so before the CPU
+ * reads what the DMA wrote its
+ * lines are invalidated, and
+ * after the CPU writes what the
+ * DMA will read they are
+ * cleaned. Buffers are whole
+ * cache lines so this never
+ * touches anything next to them.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "dmabuf.h"
+
+/**
+ * @brief Take a DMA buffer from SDRAM, it
+ *        starts on a cache line and is
+ *        rounded up to whole lines.
+ *
+ * @param bytes Number of bytes
+ *
+ * @retval The buffer, NULL if SDRAM is
+ *         out of budget
+ */
+void* dmabuf_alloc(uint32_t bytes)
+{
+	// a line shared with something else would be
+	// thrown away or written over along with ours
+	bytes = (bytes + DMABUF_LINE - 1) & ~(DMABUF_LINE - 1);
+
+	void* buffer = arena_alloc(ARENA_SDRAM, bytes, DMABUF_LINE);
+	if(buffer == NULL)
+		return NULL;
+
+	// arena memory is zeroed through the cache,
+	// get that out before the DMA starts
+	dmabuf_clean(buffer, bytes);
+	return buffer;
+}
@@ -0,0 +1,75 @@
+/**
+ * ========================
+ * File: dmabuf.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Buffers the codec DMA
+ * reads and writes. The DMA
+ * doesn't go through the
+ * D-cache, so before the CPU
+ * reads what the DMA wrote its
+ * lines are invalidated, and
+ * after the CPU writes what the
+ * DMA will read they are
+ * cleaned. Buffers are whole
+ * cache lines so this never
+ * touches anything next to them.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __DMABUF_H
+#define __DMABUF_H
+
+#include "main.h"
+#include "arena.h"
+
+// D-cache line on the M7, DMA buffers and
+// anything done to them are in whole lines
+#define DMABUF_LINE ARENA_ALIGN_CACHE
+
+/**
+ * @brief Take a DMA buffer from SDRAM, it
+ *        starts on a cache line and is
+ *        rounded up to whole lines.
+ *
+ * @param bytes Number of bytes
+ *
+ * @retval The buffer, NULL if SDRAM is
+ *         out of budget
+ */
+void* dmabuf_alloc(uint32_t bytes);
+
+/**
+ * @brief Drop the cached copy of part of a
+ *        buffer, call before reading what
+ *        the DMA has written.
+ *
+ * @param buffer Start, on a cache line
+ * @param bytes Number of bytes, whole lines
+ *
+ * @retval None
+ */
+static inline void dmabuf_invalidate(const void* buffer, uint32_t bytes)
+{
+	SCB_InvalidateDCache_by_Addr((uint32_t*)buffer, (int32_t)bytes);
+}
+
+/**
+ * @brief Write part of a buffer out of the
+ *        cache, call after writing what the
+ *        DMA will read.
+ *
+ * @param buffer Start, on a cache line
+ * @param bytes Number of bytes, whole lines
+ *
+ * @retval None
+ */
+static inline void dmabuf_clean(const void* buffer, uint32_t bytes)
+{
+	SCB_CleanDCache_by_Addr((uint32_t*)buffer, (int32_t)bytes);
+}
+
+#endif
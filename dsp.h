@@ -0,0 +1,267 @@
+/**
+ * ========================
+ * File: dsp.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: The sample and stereo
+ * frame types the effect chain
+ * runs on, and the small
+ * saturating fixed point helpers
+ * the Q15 effect kernels use.
+ *
+ * In Q15 a frame is L and R
+ * packed in one word, the same
+ * layout as the codec DMA, and
+ * the dual 16 bit instructions
+ * work on both channels at once.
+ *
+ * Build with AUDIO_FIXED_POINT
+ * set to 1 and the whole chain
+ * runs in Q15 with Q31
+ * accumulators. Left at 0 the
+ * chain runs in float.
+ *
+ * On the board the helpers use
+ * the Cortex-M7 DSP instructions,
+ * on the host they fall back to
+ * plain C.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __DSP_H
+#define __DSP_H
+
+#include "main.h"
+#include "arm_math.h"
+#include "stdint.h"
+
+#ifndef AUDIO_FIXED_POINT
+#define AUDIO_FIXED_POINT 0
+#endif
+
+/**
+ * @brief A sample on the effect bus,
+ *        full scale is +-1.0 either way
+ */
+#if AUDIO_FIXED_POINT
+typedef q15_t sample_t;
+#else
+typedef float32_t sample_t;
+#endif
+
+/**
+ * @brief A stereo frame on the effect bus.
+ *        In Q15 L is the bottom half of the
+ *        word and R the top.
+ */
+#if AUDIO_FIXED_POINT
+typedef uint32_t frame_t;
+#else
+typedef struct
+{
+	float32_t l;
+	float32_t r;
+}frame_t;
+#endif
+
+/**
+ * @brief An LFO phase. In Q15 a full turn
+ *        is 2^32 and it wraps by itself,
+ *        in float a full turn is 1.0
+ */
+#if AUDIO_FIXED_POINT
+typedef uint32_t phase_t;
+#else
+typedef float32_t phase_t;
+#endif
+
+/**
+ * @brief Saturate to Q15 (SSAT).
+ *
+ * @param x Value to saturate
+ *
+ * @retval x clamped to -32768..32767
+ */
+static inline q15_t dsp_sat_q15(int32_t x)
+{
+#ifdef HOST_SIM
+	if(x > 32767) return 32767;
+	if(x < -32768) return -32768;
+	return (q15_t)x;
+#else
+	return (q15_t)__SSAT(x, 16);
+#endif
+}
+
+/**
+ * @brief Saturating Q15 add.
+ *
+ * @param a First sample
+ * @param b Second sample
+ *
+ * @retval a + b, saturated
+ */
+static inline q15_t dsp_add_q15(q15_t a, q15_t b)
+{
+#ifdef HOST_SIM
+	return dsp_sat_q15((int32_t)a + b);
+#else
+	return (q15_t)__QADD16(a, b);
+#endif
+}
+
+/**
+ * @brief Saturating Q15 multiply.
+ *
+ * @param a First value
+ * @param b Second value
+ *
+ * @retval a * b, saturated
+ */
+static inline q15_t dsp_mul_q15(q15_t a, q15_t b)
+{
+	return dsp_sat_q15(((int32_t)a * b) >> 15);
+}
+
+#if AUDIO_FIXED_POINT
+/**
+ * @brief Pack two Q15 samples into a frame (PKHBT).
+ *
+ * @param l Left sample
+ * @param r Right sample
+ *
+ * @retval The frame
+ */
+static inline frame_t dsp_pack(q15_t l, q15_t r)
+{
+	return (uint16_t)l | ((uint32_t)(uint16_t)r << 16);
+}
+
+/**
+ * @brief Left sample of a frame.
+ *
+ * @param x Frame
+ *
+ * @retval Left sample
+ */
+static inline q15_t dsp_left(frame_t x)
+{
+	return (q15_t)(x & 0xFFFF);
+}
+
+/**
+ * @brief Right sample of a frame.
+ *
+ * @param x Frame
+ *
+ * @retval Right sample
+ */
+static inline q15_t dsp_right(frame_t x)
+{
+	return (q15_t)(x >> 16);
+}
+
+/**
+ * @brief Saturating add of both channels (QADD16).
+ *
+ * @param a First frame
+ * @param b Second frame
+ *
+ * @retval a + b, each channel saturated
+ */
+static inline frame_t dsp_add2(frame_t a, frame_t b)
+{
+#ifdef HOST_SIM
+	return dsp_pack(dsp_add_q15(dsp_left(a), dsp_left(b)),
+	                dsp_add_q15(dsp_right(a), dsp_right(b)));
+#else
+	return __QADD16(a, b);
+#endif
+}
+
+/**
+ * @brief Halving add of both channels (SHADD16),
+ *        can't overflow.
+ *
+ * @param a First frame
+ * @param b Second frame
+ *
+ * @retval (a + b) / 2, each channel
+ */
+static inline frame_t dsp_avg2(frame_t a, frame_t b)
+{
+#ifdef HOST_SIM
+	return dsp_pack((q15_t)(((int32_t)dsp_left(a) + dsp_left(b)) >> 1),
+	                (q15_t)(((int32_t)dsp_right(a) + dsp_right(b)) >> 1));
+#else
+	return __SHADD16(a, b);
+#endif
+}
+
+/**
+ * @brief Multiply each channel by its own Q15
+ *        gain (SMULBB/SMULTT), saturated.
+ *
+ * @param x Frame
+ * @param gain Left gain in the bottom half,
+ *        right gain in the top
+ *
+ * @retval x * gain, each channel
+ */
+static inline frame_t dsp_mul2(frame_t x, frame_t gain)
+{
+#ifdef HOST_SIM
+	return dsp_pack(dsp_mul_q15(dsp_left(x), dsp_left(gain)),
+	                dsp_mul_q15(dsp_right(x), dsp_right(gain)));
+#else
+	int32_t l = __SSAT(__SMULBB(x, gain) >> 15, 16);
+	int32_t r = __SSAT(__SMULTT(x, gain) >> 15, 16);
+	return __PKHBT(l, r, 16);
+#endif
+}
+#endif
+
+/**
+ * @brief Convert a control value to Q15,
+ *        use for coefficients not samples.
+ *
+ * @param x Value between -1.0 and 1.0
+ *
+ * @retval x in Q15, saturated
+ */
+static inline q15_t dsp_float_to_q15(float32_t x)
+{
+	return dsp_sat_q15((int32_t)(x * 32768.0f));
+}
+
+/**
+ * @brief Phase increment for a 32 bit phase
+ *        accumulator, a full turn is 2^32.
+ *
+ * @param freq LFO frequency
+ * @param sampleRate Sample rate
+ *
+ * @retval Phase step per sample
+ */
+static inline uint32_t dsp_phase_step(float32_t freq, float32_t sampleRate)
+{
+	return (uint32_t)((freq / sampleRate) * 4294967296.0f);
+}
+
+/**
+ * @brief Cosine of a 32 bit phase.
+ *
+ * @param phase Phase, a full turn is 2^32
+ *
+ * @retval cos(phase) in Q15
+ */
+static inline q15_t dsp_cos_q15(uint32_t phase)
+{
+	// arm_cos_q15 takes 0 to 0x7FFF for a full turn
+	return arm_cos_q15((q15_t)(phase >> 17));
+}
+
+#endif
@@ -11,11 +11,12 @@
  * want to create a new effect
  * create an effect struct!
  *
- * Last Updated: 04/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
  */
 #include "effect.h"
+#include "engine.h"
 
 // Macros for Button locations
 #define BACKBTN_X 0
@@ -181,6 +182,32 @@ void effect_draw(Effect* effect)
 	BSP_LCD_DisplayStringAt(FXNEXTBTN_X+2, FXNEXTBTN_Y+15, (uint8_t *)"param", LEFT_MODE);
 }
 
+/**
+ * @brief Turn an effect on or off. An
+ *        effect turned on starts from
+ *        silence, its reset is called first.
+ *
+ * @param effect The effect
+ * @param on 1 for on, 0 for off
+ *
+ * @retval None
+ *
+ */
+void effect_setOn(Effect* effect, int on)
+{
+	// the audio task leaves an effect alone until it
+	// is on, so its history can be cleared from here.
+	// one turned off less than a block ago is still
+	// running, and nothing it holds is stale yet
+	if(on && !effect->on && !effect->running && effect->reset)
+		effect->reset(effect->state);
+
+	// history is clear before the engine sees it on
+	__DMB();
+	effect->on = on;
+	engine_updateChain();
+}
+
 /**
  * @brief Handle a touch event on
  *        an effect window.
@@ -201,6 +228,10 @@ void effect_draw(Effect* effect)
  */
 void effect_handletouch(Effect* effect, int x, int y)
 {
+	// no effect, no window
+	if(effect == NULL)
+		return;
+
 	// BACKBTN -> go to main page
 	if(y >= BACKBTN_Y && y <= BACKBTN_Y+BACKBTN_H)
 		if(x >= BACKBTN_X && x <= BACKBTN_X+BACKBTN_W)
@@ -213,7 +244,7 @@ void effect_handletouch(Effect* effect, int x, int y)
 	if(y >= ONBTN_Y && y <= ONBTN_Y+ONBTN_H)
 		if(x >= ONBTN_X && x <= ONBTN_X+ONBTN_W)
 		{
-			effect->on = (effect->on == 1) ? 0 : 1;
+			effect_setOn(effect, (effect->on == 1) ? 0 : 1);
 			draw_on_button(effect);
 			return;
 		}
@@ -229,6 +260,7 @@ void effect_handletouch(Effect* effect, int x, int y)
 						effect->paramValues[effect->currentParam] -
 						effect->parameters[effect->currentParam].tick))
 			);
+			effect_postParams(effect);
 
 			effect_drawparam(effect);
 			return;
@@ -245,6 +277,7 @@ void effect_handletouch(Effect* effect, int x, int y)
 						effect->paramValues[effect->currentParam] +
 						effect->parameters[effect->currentParam].tick))
 			);
+			effect_postParams(effect);
 			effect_drawparam(effect);
 			return;
 		}
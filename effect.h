@@ -11,7 +11,7 @@
  * want to create a new effect
  * create an effect struct!
  *
- * Last Updated: 04/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -19,6 +19,10 @@
 #define EFFECT_H_
 
 #include "main.h"
+#include "dsp.h"
+#include "mailbox.h"
+#include "arena.h"
+#include "profile.h"
 #include "stdint.h"
 
 /**
@@ -36,19 +40,88 @@ typedef struct
 /**
  * @brief The effect struct
  *        use this!
+ *
+ *        processBuffer gets the effects
+ *        own state, a block of input and
+ *        a block of output. The input and
+ *        output may be the same block.
+ *        Blocks are stereo frame_t, float
+ *        or packed Q15 depending on
+ *        AUDIO_FIXED_POINT. With a mono
+ *        input both channels start the
+ *        same, so an effect can make a
+ *        mono input stereo.
+ *        Full scale is +-1.0, in float
+ *        there is headroom above that and
+ *        the engine saturates once on the
+ *        way out. Q15 kernels saturate as
+ *        they go.
+ *
+ *        paramValues belong to the touch
+ *        screen. Changes are posted to
+ *        mailbox and the engine copies
+ *        them into audioValues between
+ *        blocks, the kernel only reads
+ *        audioValues.
+ *
+ *        prepare is called after new
+ *        audioValues are taken or the
+ *        sample rate changes, work out
+ *        anything derived from them there
+ *        and keep it in state. Can be NULL.
+ *        sampleRate is the rate it was
+ *        last prepared for.
+ *
+ *        reset clears the effects history,
+ *        delay lines, filter memory and lfo
+ *        phase, but not what prepare worked
+ *        out. It is called when an effect is
+ *        turned back on so it doesn't replay
+ *        what it held when it was turned off.
+ *        Can be NULL. running is set by the
+ *        engine while the effect is in the
+ *        compiled routing, or still ringing
+ *        out after it was turned off.
+ *
+ *        tail is for effects that keep
+ *        sounding after their input stops.
+ *        It gives the longest quiet gap the
+ *        output can have while it's still
+ *        ringing, in frames, the delay length
+ *        for a delay. Once turned off such an
+ *        effect is kept running on silence
+ *        until a whole tail of its output is
+ *        quiet, and what it gives is mixed
+ *        into the output. Can be NULL.
+ *
+ *        type picks the kernel the engine
+ *        calls, see registry.h.
+ *        processBuffer is only called for
+ *        effects that aren't in the list.
  */
 typedef struct
 {
+	EffectType type;
 	int on;
 	char name[40];
 	int currentParam;
 	int paramNum;
 	Parameter* parameters;
 	float* paramValues;
+	ParamMailbox mailbox;
+	float audioValues[MAILBOX_VALUES_MAX];
+	void* state;
+	uint32_t sampleRate;
+	volatile int running;
+	ProfileStats profile; // cycles processBuffer takes, kept by the engine
+	void (*prepare)(void* state, uint32_t sampleRate);
+	void (*reset)(void* state);
+	uint32_t (*tail)(void* state);
 	void (*processBuffer)(
-			uint16_t* inputData,
-			uint16_t* outputData,
-			uint32_t offset);
+			void* state,
+			const frame_t* inputData,
+			frame_t* outputData,
+			uint32_t frames);
 }Effect;
 
 /**
@@ -85,4 +158,32 @@ void effect_draw(Effect* effect);
  */
 void effect_handletouch(Effect* effect, int x, int y);
 
+/**
+ * @brief Turn an effect on or off. An
+ *        effect turned on starts from
+ *        silence, its reset is called first.
+ *
+ * @param effect The effect
+ * @param on 1 for on, 0 for off
+ *
+ * @retval None
+ *
+ */
+void effect_setOn(Effect* effect, int on);
+
+/**
+ * @brief Hand the effects parameters to
+ *        the audio loop, call this after
+ *        changing paramValues.
+ *
+ * @param effect The effect
+ *
+ * @retval None
+ *
+ */
+static inline void effect_postParams(Effect* effect)
+{
+	mailbox_post(&effect->mailbox, effect->paramValues, effect->paramNum);
+}
+
 #endif
@@ -0,0 +1,51 @@
+/**
+ * ========================
+ * File: effectlist.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: The list of effects
+ * on the pedal. Everything
+ * that needs one entry per
+ * effect is made from this
+ * list: the window enum, the
+ * effect table, the init calls,
+ * the main window buttons and
+ * the kernel dispatch.
+ *
+ * To add an effect give it a
+ * line here and include its
+ * header in registry.h. It
+ * needs name_create() and
+ * name_processBuffer().
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __EFFECTLIST_H
+#define __EFFECTLIST_H
+
+// X(name, NAME, button label), list order is the
+// order effects are run in and their buttons
+#define EFFECT_LIST(X) \
+	X(wahwah,     WAHWAH,     "WAHWAH")     \
+	X(distortion, DISTORTION, "DISTORTION") \
+	X(flanger,    FLANGER,    "FLANGER")    \
+	X(vibrato,    VIBRATO,    "VIBRATO")    \
+	X(delay,      DELAY,      "DELAY")      \
+	X(tremolo,    TREMOLO,    "TREMOLO")
+
+/**
+ * @brief What kind of effect an Effect is,
+ *        used to pick its kernel
+ */
+typedef enum
+{
+#define EFFECT_TYPE_ENUM(name, NAME, label) EFFECT_##NAME,
+	EFFECT_LIST(EFFECT_TYPE_ENUM)
+#undef EFFECT_TYPE_ENUM
+	EFFECT_NUM, // number of effects, not an effect
+}EffectType;
+
+#endif
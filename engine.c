@@ -0,0 +1,1046 @@
+/**
+ * ========================
+ * File: engine.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: The audio engine. The
+ * DMA half/full transfer
+ * callbacks queue blocks and
+ * wake the audio task, which
+ * processes them through the
+ * effects.
+ * Overruns and underruns are
+ * counted so we can tell when
+ * a block was missed.
+ *
+ * With nothing on the block is
+ * copied straight through and
+ * the core goes back to sleep.
+ * An effect with a tail, like the
+ * delay, is left to ring out
+ * first.
+ *
+ * If the SAI reports an error,
+ * playback drifts off the half it
+ * should be on, or blocks keep
+ * getting missed, both streams
+ * are restarted together.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "engine.h"
+#include "registry.h"
+
+#ifndef HOST_SIM
+// playback SAI handle from the BSP, we
+// read its DMA counter to check for drift
+extern SAI_HandleTypeDef haudio_out_sai;
+#endif
+
+// used as bit flags, both halves
+// can be waiting at the same time
+typedef enum
+{
+  BUFFER_OFFSET_NONE = 0,
+  BUFFER_OFFSET_HALF = 1,
+  BUFFER_OFFSET_FULL = 2,
+}BUFFER_StateTypeDef;
+
+// blocks the DMA has filled that we
+// haven't processed yet, and the last
+// half the DMA told us about
+static volatile uint8_t pending_blocks;
+static volatile uint8_t last_event;
+
+// count of DMA events, and which event
+// each pending block arrived on
+static volatile uint32_t dma_events;
+static volatile uint32_t ready_event[3];
+
+// counters
+static volatile uint32_t overruns;
+static uint32_t underruns;
+static uint32_t blocks;
+static uint32_t bypassed;
+static volatile uint32_t errors;
+static uint32_t drifts;
+static uint32_t recoveries;
+
+// set by the SAI error callbacks or when
+// playback has drifted, and how
+// many blocks in a row have had an xrun
+static volatile uint8_t stream_error;
+static uint32_t xrun_streak;
+static uint32_t seen_overruns;
+
+// CPU load, averaged and peak, in %
+static float load;
+static float load_peak;
+
+// cycles each block takes, the effects
+// keep their own in Effect.profile
+static ProfileStats block_profile;
+
+// routing we're running, compiled into the
+// steps for the effects that are on, and
+// the routing we've been asked for. the
+// audio task writes that back if it won't
+// compile, so other tasks only touch it
+// with the audio task locked out
+static RouteGraph route;
+static AUDIO_DTCM RouteSchedule schedule;
+static RouteGraph requested_route;
+
+// set when the routing needs compiling
+static volatile uint8_t route_dirty;
+
+// run effects through fused kernels where we can. the
+// Q15 kernels are cheap enough that fusing them saves
+// nothing (host/bench_fused.c), so they start off there
+static volatile uint8_t fused_kernels = !AUDIO_FIXED_POINT;
+
+// stereo blocks for the routing, the block from the
+// codec goes in the first one. effects work in place
+// where they can. history lives in each effects delay
+// line. in float, codec samples are only converted at
+// the edges. in Q15 the codec format is the bus format.
+// they come from DTCM, next to the effects state.
+static frame_t* route_buffers[ROUTE_BUFFERS_MAX];
+
+// effects turned off that are still ringing out, the
+// frames of quiet each has given since it was last
+// loud, and the block they're run in on silence
+static Effect* tail_effects[ROUTE_NODES_MAX];
+static uint32_t tail_quiet[ROUTE_NODES_MAX];
+static int tail_num;
+static frame_t* tail_buffer;
+
+// a tail below this is quiet, a few LSBs of the codec.
+// Q15 feedback rounds down, so a tail can sit at -1
+#if AUDIO_FIXED_POINT
+#define ENGINE_TAIL_FLOOR 4
+#else
+#define ENGINE_TAIL_FLOOR (4.0f/32768.0f)
+#endif
+
+// record and playback DMA buffers, in SDRAM.
+// the cache is kept in step a half at a time
+static int16_t* dma_in_buffer;
+static int16_t* dma_out_buffer;
+
+// block size in use, and the one the
+// latency menu has asked for
+static uint32_t block_frames;
+static volatile uint32_t requested_frames;
+
+// sample rate in use, and the one asked for
+static uint32_t sample_rate;
+static volatile uint32_t requested_rate;
+
+// volume in use, put back when the streams
+// restart, and the one the UI has asked for
+static uint8_t volume;
+static volatile uint8_t requested_volume;
+
+/**
+ * @brief Queue a block for processing.
+ *        Called from the DMA callbacks.
+ *
+ * @param state Which half has been filled
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void engine_dmaEvent(uint8_t state)
+{
+	trace_event(state == BUFFER_OFFSET_HALF ? TRACE_DMA_HALF : TRACE_DMA_FULL, 0);
+
+	// still waiting on this half, the DMA has written
+	// over it so that block is lost. or the same half
+	// twice, we've missed the other one
+	if((pending_blocks & state) || last_event == state)
+	{
+		overruns++;
+		trace_event(TRACE_OVERRUN, 0);
+	}
+
+	dma_events++;
+	ready_event[state] = dma_events;
+	pending_blocks |= state;
+	last_event = state;
+
+	task_signal(TASK_AUDIO);
+}
+
+/**
+ * @brief Call backs for our DMA transfers
+ *        Queue the block that has been filled
+ *
+ * @param None
+ *
+ * @retval None
+ *
+ */
+AUDIO_ITCM void BSP_AUDIO_IN_TransferComplete_CallBack(void)
+{
+	engine_dmaEvent(BUFFER_OFFSET_FULL);
+}
+/*
+* @param None
+*
+* @retval None
+*/
+AUDIO_ITCM void BSP_AUDIO_IN_HalfTransfer_CallBack(void)
+{
+	engine_dmaEvent(BUFFER_OFFSET_HALF);
+}
+/*
+* @param None
+*
+* @retval None
+*/
+void BSP_AUDIO_IN_Error_CallBack(void)
+{
+	// the engine restarts the streams
+	errors++;
+	stream_error = 1;
+}
+/*
+* @param None
+*
+* @retval None
+*/
+void BSP_AUDIO_OUT_Error_CallBack(void)
+{
+	errors++;
+	stream_error = 1;
+}
+
+/**
+ * @brief Which half the playback DMA is on.
+ *
+ * @param None
+ *
+ * @retval BUFFER_OFFSET_HALF or BUFFER_OFFSET_FULL
+ */
+static AUDIO_ITCM uint8_t engine_playbackHalf(void)
+{
+#ifdef HOST_SIM
+	return hostsim_play_half() ? BUFFER_OFFSET_FULL : BUFFER_OFFSET_HALF;
+#else
+	// the counter is half-words left to send,
+	// 2 halves of 2 channels
+	uint32_t left = __HAL_DMA_GET_COUNTER(haudio_out_sai.hdmatx);
+	return (left > block_frames*2) ? BUFFER_OFFSET_HALF : BUFFER_OFFSET_FULL;
+#endif
+}
+
+/**
+ * @brief Copy a block straight from the record
+ *        half to the playback half, used when
+ *        no effect is on. Codec samples are
+ *        already what we'd play, so there's
+ *        nothing to convert.
+ *
+ * @param dma_in Record half
+ * @param dma_out Playback half
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void engine_bypassBlock(const int16_t* dma_in, int16_t* dma_out)
+{
+#if AUDIO_INPUT_MONO
+	// guitar is on the left, play it on both
+	for(uint32_t i = 0; i < block_frames; i++)
+	{
+		dma_out[2*i]   = dma_in[2*i];
+		dma_out[2*i+1] = dma_in[2*i];
+	}
+#else
+	memcpy(dma_out, dma_in, block_frames * 2 * sizeof(int16_t));
+#endif
+}
+
+/**
+ * @brief Pick up parameters the touch screen
+ *        has changed, a whole set at a time,
+ *        and prepare the effect if they or
+ *        the sample rate changed.
+ *
+ * @param effect The effect
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void engine_prepareEffect(Effect* effect)
+{
+	// only work coefficients out when they change
+	int changed = mailbox_fetch(&effect->mailbox, effect->audioValues, effect->paramNum);
+	if((changed || effect->sampleRate != sample_rate) && effect->prepare)
+		effect->prepare(effect->state, sample_rate);
+	effect->sampleRate = sample_rate;
+}
+
+/**
+ * @brief Run the effects ringing out on silence
+ *        and mix what they give into the block.
+ *        One is dropped once a whole tail of
+ *        it has been quiet.
+ *
+ * @param block The block on its way out
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void engine_runTails(frame_t* block)
+{
+	for(int i = 0; i < tail_num; i++)
+	{
+		Effect* effect = tail_effects[i];
+#if AUDIO_FIXED_POINT
+		int32_t peak = 0;
+#else
+		float peak = 0.0f;
+#endif
+
+		engine_prepareEffect(effect);
+
+		memset(tail_buffer, 0, block_frames * sizeof(frame_t));
+		registry_process(effect, tail_buffer, tail_buffer, block_frames);
+
+		for(uint32_t j = 0; j < block_frames; j++)
+		{
+#if AUDIO_FIXED_POINT
+			int32_t l = dsp_left(tail_buffer[j]);
+			int32_t r = dsp_right(tail_buffer[j]);
+			l = (l < 0) ? -l : l;
+			r = (r < 0) ? -r : r;
+			peak = (l > peak) ? l : peak;
+			peak = (r > peak) ? r : peak;
+			block[j] = dsp_add2(block[j], tail_buffer[j]);
+#else
+			peak = fmaxf(peak, fmaxf(fabsf(tail_buffer[j].l), fabsf(tail_buffer[j].r)));
+			block[j].l += tail_buffer[j].l;
+			block[j].r += tail_buffer[j].r;
+#endif
+		}
+
+		if(peak >= ENGINE_TAIL_FLOOR)
+			tail_quiet[i] = 0;
+		else
+			tail_quiet[i] += block_frames;
+
+		// rung out, it can be reset again
+		if(tail_quiet[i] >= effect->tail(effect->state))
+		{
+			effect->running = 0;
+			tail_num--;
+			tail_effects[i] = tail_effects[tail_num];
+			tail_quiet[i] = tail_quiet[tail_num];
+			i--;
+		}
+	}
+}
+
+/**
+ * @brief Run one block through the effects
+ *        and into the playback buffer.
+ *
+ * @param state Which half of the DMA buffers to use
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void engine_processBlock(uint8_t state)
+{
+	// the DMA halves for this block
+	int16_t* dma_in  = dma_in_buffer;
+	int16_t* dma_out = dma_out_buffer;
+	uint32_t half_bytes = block_frames*2*sizeof(int16_t);
+	frame_t* audio_block = route_buffers[0];
+
+	if(state == BUFFER_OFFSET_FULL)
+	{
+		dma_in  += block_frames*2;
+		dma_out += block_frames*2;
+	}
+
+	// the DMA wrote this half behind the cache,
+	// drop what we had cached of it
+	dmabuf_invalidate(dma_in, half_bytes);
+
+	// nothing on or ringing out, skip the effect bus
+	if(schedule.stepNum == 0 && tail_num == 0)
+	{
+		engine_bypassBlock(dma_in, dma_out);
+		dmabuf_clean(dma_out, half_bytes);
+		bypassed++;
+		return;
+	}
+
+#if AUDIO_FIXED_POINT
+	// the DMA half is already packed frames
+#if AUDIO_INPUT_MONO
+	for(uint32_t i = 0; i < block_frames; i++)
+		audio_block[i] = dsp_pack(dma_in[2*i], dma_in[2*i]);
+#else
+	memcpy(audio_block, dma_in, block_frames * sizeof(frame_t));
+#endif
+#else
+	// convert the whole DMA half to float, L and R
+	// are interleaved the same way as a frame_t
+	arm_q15_to_float(dma_in, (float32_t*)audio_block, block_frames*2);
+#if AUDIO_INPUT_MONO
+	for(uint32_t i = 0; i < block_frames; i++)
+		audio_block[i].r = audio_block[i].l;
+#endif
+#endif
+
+	for(int i = 0; i < schedule.effectNum; i++)
+		engine_prepareEffect(schedule.effects[i]);
+
+	// process our audio with our effects
+	route_run(&schedule, route_buffers, block_frames);
+	audio_block = route_buffers[schedule.output];
+
+	// echoes of effects that have been turned off
+	engine_runTails(audio_block);
+
+#if AUDIO_FIXED_POINT
+	// out to the playback half
+	memcpy(dma_out, audio_block, block_frames * sizeof(frame_t));
+#else
+	// back to the codec format and out to the playback
+	// half, this saturates so anything over full scale
+	// clips here
+	arm_float_to_q15((float32_t*)audio_block, dma_out, block_frames*2);
+#endif
+
+	// out to SDRAM for the DMA to play
+	dmabuf_clean(dma_out, half_bytes);
+}
+
+/**
+ * @brief Empty the block profile and the
+ *        profile of each effect in the routing.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+static void engine_clearProfile(void)
+{
+	profile_reset(&block_profile);
+
+	for(int n = 0; n < route.nodeNum; n++)
+		if(route.nodes[n].type == ROUTE_EFFECT)
+			profile_reset(&route.nodes[n].effect->profile);
+}
+
+/**
+ * @brief (Re)start the codec and both DMA
+ *        streams at the current block size.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+static void engine_startStreams(void)
+{
+	// cycles a block lasts, times against
+	// another budget don't mix so start again
+	uint32_t budget = (uint32_t)((uint64_t)block_frames * SystemCoreClock / sample_rate);
+	if(budget != profile_getBudget())
+	{
+		profile_setBudget(budget);
+		engine_clearProfile();
+	}
+
+	BSP_AUDIO_IN_OUT_Init(
+			INPUT_DEVICE_INPUT_LINE_1,
+			OUTPUT_DEVICE_HEADPHONE,
+			sample_rate,
+			DEFAULT_AUDIO_IN_BIT_RESOLUTION,
+			DEFAULT_AUDIO_IN_CHANNEL_NBR);
+
+#ifndef HOST_SIM
+	// the BSP puts record below playback, both have
+	// to be able to break into the audio task
+	HAL_NVIC_SetPriority(AUDIO_IN_SAIx_DMAx_IRQ, TASK_IRQ_PRIORITY_DMA, 0);
+	HAL_NVIC_SetPriority(AUDIO_OUT_SAIx_DMAx_IRQ, TASK_IRQ_PRIORITY_DMA, 0);
+#endif
+
+	// audio buffers, make sure there clean
+	// and out of the cache, a dirty line left in the
+	// record buffer could be written over the DMA
+	memset(dma_in_buffer, 0, AUDIO_DMA_BUFFER_BYTES);
+	memset(dma_out_buffer, 0, AUDIO_DMA_BUFFER_BYTES);
+	dmabuf_clean(dma_in_buffer, AUDIO_DMA_BUFFER_BYTES);
+	dmabuf_clean(dma_out_buffer, AUDIO_DMA_BUFFER_BYTES);
+
+	pending_blocks = BUFFER_OFFSET_NONE;
+	last_event = BUFFER_OFFSET_NONE;
+
+	// start the audio loop back using the BSP audio drivers
+	// 2 halves of 2 channels, record size is in half-words
+	// and play size is in bytes
+	BSP_AUDIO_IN_Record((uint16_t*)dma_in_buffer, block_frames*4);
+	BSP_AUDIO_OUT_SetAudioFrameSlot(CODEC_AUDIOFRAME_SLOT_02);
+	BSP_AUDIO_OUT_Play((uint16_t*)dma_out_buffer, block_frames*8);
+	BSP_AUDIO_OUT_SetMute(AUDIO_MUTE_OFF);
+	BSP_AUDIO_OUT_SetVolume(volume);
+}
+
+/**
+ * @brief Switch to the block size and sample rate
+ *        the latency menu asked for. Streams are
+ *        stopped and restarted since the DMA length
+ *        and codec clock change.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+static void engine_applyStreamSettings(void)
+{
+	BSP_AUDIO_OUT_SetMute(AUDIO_MUTE_ON);
+	BSP_AUDIO_IN_Stop(CODEC_PDWN_SW);
+	BSP_AUDIO_OUT_Stop(CODEC_PDWN_SW);
+
+	// effects see the new rate and
+	// prepare again before their next block
+	block_frames = requested_frames;
+	sample_rate = requested_rate;
+
+	engine_startStreams();
+}
+
+/**
+ * @brief Get the streams going again after an SAI
+ *        error or a run of xruns. Both are stopped
+ *        and started from the top of their buffers
+ *        so record and playback are back in step.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+static void engine_recoverStreams(void)
+{
+	stream_error = 0;
+	xrun_streak = 0;
+	recoveries++;
+
+	// restarts at the settings asked for, same as
+	// a latency change would
+	engine_applyStreamSettings();
+}
+
+/**
+ * @brief Take the routing we've been asked for
+ *        and compile it for the effects that are
+ *        on. The old routing is kept if it won't
+ *        compile. Marks which effects are running.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+static void engine_compileRoute(void)
+{
+	Effect* dropped[ROUTE_NODES_MAX];
+	int droppedNum = schedule.effectNum;
+
+	route_dirty = 0;
+	memcpy(dropped, schedule.effects, droppedNum * sizeof(Effect*));
+
+	if(route_compile(&requested_route, &schedule) == 0)
+		route = requested_route;
+	else
+	{
+		requested_route = route;
+		route_compile(&route, &schedule);
+	}
+
+	if(fused_kernels)
+		route_fuse(&schedule);
+
+	// effect_setOn() only resets an effect that isn't
+	// running, so never clear one that still is, even
+	// for a moment
+	for(int i = 0; i < schedule.effectNum; i++)
+		schedule.effects[i]->running = 1;
+
+	// one turned back on while ringing out
+	// carries on from where its tail is
+	for(int i = 0; i < tail_num; i++)
+		for(int j = 0; j < schedule.effectNum; j++)
+			if(tail_effects[i] == schedule.effects[j])
+			{
+				tail_num--;
+				tail_effects[i] = tail_effects[tail_num];
+				tail_quiet[i] = tail_quiet[tail_num];
+				i--;
+				break;
+			}
+
+	// one with a tail is left to ring out,
+	// the rest stop here
+	for(int i = 0; i < droppedNum; i++)
+	{
+		int kept = 0;
+		for(int j = 0; j < schedule.effectNum; j++)
+			kept |= (dropped[i] == schedule.effects[j]);
+		if(kept)
+			continue;
+
+		if(dropped[i]->tail && tail_num < ROUTE_NODES_MAX)
+		{
+			tail_effects[tail_num] = dropped[i];
+			tail_quiet[tail_num] = 0;
+			tail_num++;
+		}
+		else
+			dropped[i]->running = 0;
+	}
+}
+
+/**
+ * @brief Add a block's time to the CPU load.
+ *
+ * @param cycles Cycles the block took
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void engine_updateLoad(uint32_t cycles)
+{
+	// cycles a block lasts at this rate
+	float period = (float)block_frames * SystemCoreClock / sample_rate;
+	float blockLoad = cycles * 100.0f / period;
+
+	// average over about 16 blocks
+	load += (blockLoad - load) / 16.0f;
+
+	if(blockLoad > load_peak)
+		load_peak = blockLoad;
+}
+
+/**
+ * @brief Initialise the engine with the
+ *        effects it should run, in order.
+ *        Its buffers come from the arenas,
+ *        call arena_init() first. Stops in
+ *        Error_Handler() if they don't fit.
+ *
+ * @param effects Table of effects to process,
+ *        NULL to play straight through until
+ *        engine_setOrder() hands some over
+ * @param effectNum Number of effects in the table
+ *
+ * @retval None
+ */
+void engine_init(Effect** effects, int effectNum)
+{
+	for(int i = 0; i < ROUTE_BUFFERS_MAX; i++)
+		route_buffers[i] = arena_alloc(ARENA_DTCM, AUDIO_BLOCK_FRAMES_MAX*sizeof(frame_t), ARENA_ALIGN_CACHE);
+	tail_buffer = arena_alloc(ARENA_DTCM, AUDIO_BLOCK_FRAMES_MAX*sizeof(frame_t), ARENA_ALIGN_CACHE);
+
+	dma_in_buffer = dmabuf_alloc(AUDIO_DMA_BUFFER_BYTES);
+	dma_out_buffer = dmabuf_alloc(AUDIO_DMA_BUFFER_BYTES);
+
+	// nothing can play without these, say which
+	// region ran out and stop before the streams
+	// start writing through them
+	int missing = (dma_in_buffer == NULL || dma_out_buffer == NULL || tail_buffer == NULL);
+	for(int i = 0; i < ROUTE_BUFFERS_MAX; i++)
+		if(route_buffers[i] == NULL)
+			missing = 1;
+
+	if(missing)
+	{
+		arena_report();
+		Error_Handler();
+	}
+
+	// straight through until we have a routing
+	tail_num = 0;
+	route_init(&route);
+	engine_setOrder(effects, effectNum);
+	engine_compileRoute();
+
+	pending_blocks = BUFFER_OFFSET_NONE;
+	last_event = BUFFER_OFFSET_NONE;
+	dma_events = 0;
+	overruns = 0;
+	underruns = 0;
+	blocks = 0;
+	bypassed = 0;
+	errors = 0;
+	drifts = 0;
+	recoveries = 0;
+	stream_error = 0;
+	xrun_streak = 0;
+	seen_overruns = 0;
+	load = 0;
+	load_peak = 0;
+
+	// cycle counter for the load and profile
+	profile_init();
+	profile_reset(&block_profile);
+
+	block_frames = AUDIO_BLOCK_FRAMES_DEFAULT;
+	requested_frames = AUDIO_BLOCK_FRAMES_DEFAULT;
+	sample_rate = AUDIO_SAMPLE_RATE_DEFAULT;
+	requested_rate = AUDIO_SAMPLE_RATE_DEFAULT;
+
+	// 70 is our default volume
+	volume = 70;
+	requested_volume = 70;
+}
+
+/**
+ * @brief Change the order effects are run in.
+ *        Takes effect before the next block.
+ *
+ * @param effects Table of effects to process
+ * @param effectNum Number of effects in the table
+ *
+ * @retval None
+ */
+void engine_setOrder(Effect** effects, int effectNum)
+{
+	RouteGraph graph;
+
+	route_serial(&graph, effects, effectNum);
+	engine_setRoute(&graph);
+}
+
+/**
+ * @brief Route the effects through a graph,
+ *        for parallel paths. The graph is
+ *        copied, and takes effect before the
+ *        next block. If it needs too many
+ *        buffers the old routing is kept.
+ *
+ * @param graph The routing graph
+ *
+ * @retval None
+ */
+void engine_setRoute(const RouteGraph* graph)
+{
+	task_lockAudio();
+	requested_route = *graph;
+	route_dirty = 1;
+	task_unlockAudio();
+}
+
+/**
+ * @brief Recompile the routing, call this when
+ *        an effect is turned on or off. Takes
+ *        effect before the next block.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_updateChain(void)
+{
+	route_dirty = 1;
+}
+
+/**
+ * @brief Turn the fused kernels on or off, off
+ *        runs every effect in its own pass.
+ *        Takes effect before the next block.
+ *
+ * @param on 1 to fuse, 0 not to
+ *
+ * @retval None
+ */
+void engine_setFusedKernels(int on)
+{
+	fused_kernels = on;
+	route_dirty = 1;
+}
+
+/**
+ * @brief Start the codec and the record
+ *        and playback DMA streams.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_start(void)
+{
+	engine_startStreams();
+}
+
+/**
+ * @brief Process every block the DMA
+ *        callbacks have queued, oldest first.
+ *
+ * @param None
+ *
+ * @retval Number of blocks processed
+ */
+AUDIO_ITCM int engine_service(void)
+{
+	int processed = 0;
+
+	// SAI fault or the streams have drifted
+	if(stream_error || xrun_streak >= ENGINE_XRUN_RESTART)
+		engine_recoverStreams();
+	// latency menu wants a new block size or rate
+	else if(requested_frames != block_frames || requested_rate != sample_rate)
+		engine_applyStreamSettings();
+
+	// the codec is on the same I2C bus as the touch
+	// screen, so only this task ever talks to it
+	if(requested_volume != volume)
+	{
+		volume = requested_volume;
+		trace_event(TRACE_VOLUME_START, volume);
+		BSP_AUDIO_OUT_SetVolume(volume);
+		trace_event(TRACE_VOLUME_END, volume);
+	}
+
+	// routing changed or an effect was turned on or off
+	if(route_dirty)
+		engine_compileRoute();
+
+	while(pending_blocks)
+	{
+		uint8_t state;
+		uint32_t event;
+
+		__disable_irq();
+
+		// both waiting, the older one is
+		// the half we weren't told about last
+		if(pending_blocks == (BUFFER_OFFSET_HALF | BUFFER_OFFSET_FULL))
+			state = (last_event == BUFFER_OFFSET_HALF) ? BUFFER_OFFSET_FULL : BUFFER_OFFSET_HALF;
+		else
+			state = pending_blocks;
+
+		pending_blocks &= ~state;
+		event = ready_event[state];
+
+		__enable_irq();
+
+		// playback should be on the other half to the one
+		// we're about to write, unless we're already late.
+		// if it isn't, record and playback have drifted
+		if(dma_events == event && engine_playbackHalf() == state)
+		{
+			drifts++;
+			stream_error = 1;
+		}
+
+		trace_event(TRACE_BLOCK_START, state);
+		uint32_t start = profile_cycles();
+		engine_processBlock(state);
+		uint32_t cycles = profile_cycles() - start;
+		trace_event(TRACE_BLOCK_END, state);
+		engine_updateLoad(cycles);
+		profile_add(&block_profile, cycles);
+
+		// playback moves onto this half at the next
+		// DMA event, if that's happened we were late
+		int late = dma_events != event;
+		if(late)
+		{
+			underruns++;
+			trace_event(TRACE_UNDERRUN, 0);
+		}
+
+		// a block lost or late, count the run of them
+		if(late || overruns != seen_overruns)
+			xrun_streak++;
+		else
+			xrun_streak = 0;
+		seen_overruns = overruns;
+
+		blocks++;
+		processed++;
+
+		// restart now rather than on the next call, a
+		// block on time after the run would clear it.
+		// what's still waiting is thrown away with it
+		if(stream_error || xrun_streak >= ENGINE_XRUN_RESTART)
+		{
+			engine_recoverStreams();
+			break;
+		}
+	}
+
+	return processed;
+}
+
+/**
+ * @brief Copy out the engine counters.
+ *
+ * @param stats Where to put the counters
+ *
+ * @retval None
+ */
+void engine_getStats(EngineStats* stats)
+{
+	stats->blocks = blocks;
+	stats->overruns = overruns;
+	stats->underruns = underruns;
+	stats->bypassed = bypassed;
+	stats->errors = errors;
+	stats->drifts = drifts;
+	stats->recoveries = recoveries;
+	stats->load = load;
+	stats->loadPeak = load_peak;
+}
+
+/**
+ * @brief Start the peak load again, so it
+ *        shows the peak from now on.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_resetLoadPeak(void)
+{
+	load_peak = 0;
+}
+
+/**
+ * @brief Copy out the cycles an effect or
+ *        the whole block has taken.
+ *
+ * @param effect The effect, NULL for the block
+ * @param stats Where to put them
+ *
+ * @retval None
+ */
+void engine_getProfile(const Effect* effect, ProfileStats* stats)
+{
+	task_lockAudio();
+	*stats = effect ? effect->profile : block_profile;
+	task_unlockAudio();
+}
+
+/**
+ * @brief Start the profile of the block
+ *        and every effect in the routing
+ *        again, so it shows from now on.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_resetProfile(void)
+{
+	task_lockAudio();
+	engine_clearProfile();
+	task_unlockAudio();
+}
+
+/**
+ * @brief Print the block profile and the
+ *        profile of each effect in the routing.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_printProfile(void)
+{
+	ProfileStats stats;
+
+	printf("profile, block budget %lu us\r\n", (unsigned long)profile_toMicros(profile_getBudget()));
+
+	engine_getProfile(NULL, &stats);
+	profile_print("block", &stats);
+
+	for(int n = 0; n < route.nodeNum; n++)
+		if(route.nodes[n].type == ROUTE_EFFECT)
+		{
+			engine_getProfile(route.nodes[n].effect, &stats);
+			profile_print(route.nodes[n].effect->name, &stats);
+		}
+}
+
+/**
+ * @brief Ask for a new block size, it is
+ *        switched over between blocks.
+ *
+ * @param frames Frames per block, a power of 2
+ *        between AUDIO_BLOCK_FRAMES_MIN and
+ *        AUDIO_BLOCK_FRAMES_MAX
+ *
+ * @retval None
+ */
+void engine_setBlockFrames(uint32_t frames)
+{
+	// must be a power of 2 and in range
+	if(frames < AUDIO_BLOCK_FRAMES_MIN || frames > AUDIO_BLOCK_FRAMES_MAX)
+		return;
+	if(frames & (frames - 1))
+		return;
+
+	requested_frames = frames;
+}
+
+/**
+ * @brief Block size the engine has been
+ *        asked for, this is what the
+ *        latency menu shows.
+ *
+ * @param None
+ *
+ * @retval Frames per block
+ */
+uint32_t engine_getBlockFrames(void)
+{
+	return requested_frames;
+}
+
+/**
+ * @brief Ask for a new codec volume, the audio
+ *        task sets it before the next block.
+ *        It is put back when the streams restart.
+ *
+ * @param newVolume Volume 0 to 100
+ *
+ * @retval None
+ */
+void engine_setVolume(uint8_t newVolume)
+{
+	requested_volume = newVolume;
+}
+
+/**
+ * @brief Ask for a new sample rate, it is
+ *        switched over between blocks.
+ *
+ * @param rate 44100, 48000 or 96000
+ *
+ * @retval None
+ */
+void engine_setSampleRate(uint32_t rate)
+{
+	if(rate != I2S_AUDIOFREQ_44K && rate != I2S_AUDIOFREQ_48K && rate != I2S_AUDIOFREQ_96K)
+		return;
+
+	requested_rate = rate;
+}
+
+/**
+ * @brief Sample rate the engine has been
+ *        asked for, this is what the
+ *        latency menu shows.
+ *
+ * @param None
+ *
+ * @retval Sample rate
+ */
+uint32_t engine_getSampleRate(void)
+{
+	return requested_rate;
+}
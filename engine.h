@@ -0,0 +1,262 @@
+/**
+ * ========================
+ * File: engine.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: The audio engine. The
+ * DMA half/full transfer
+ * callbacks queue blocks and
+ * wake the audio task, which
+ * processes them through the
+ * effects.
+ * Overruns and underruns are
+ * counted so we can tell when
+ * a block was missed.
+ *
+ * Effects are run through a
+ * routing graph, which is
+ * recompiled when an effect is
+ * turned on or off so only the
+ * effects that are on are run.
+ * With nothing on the block is
+ * copied straight through and
+ * the core goes back to sleep.
+ *
+ * The streams are restarted if
+ * the SAI reports an error,
+ * record and playback drift apart
+ * or blocks keep getting missed.
+ *
+ * CPU load is the time spent on
+ * a block against the time the
+ * block lasts.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __ENGINE_H
+#define __ENGINE_H
+
+#include "main.h"
+#include "effect.h"
+#include "route.h"
+#include "arena.h"
+#include "dmabuf.h"
+#include "tasks.h"
+#include "trace.h"
+
+// blocks in a row that can miss before
+// we give up and restart the streams
+#define ENGINE_XRUN_RESTART 4
+
+/**
+ * @brief Engine counters, read these
+ *        with engine_getStats()
+ */
+typedef struct
+{
+	uint32_t blocks;    // blocks processed
+	uint32_t overruns;  // input blocks lost before we processed them
+	uint32_t underruns; // output blocks not ready in time for playback
+	uint32_t bypassed;  // blocks copied straight through, nothing on
+	uint32_t errors;    // SAI errors reported
+	uint32_t drifts;    // times playback was found on the half being written
+	uint32_t recoveries; // times the streams were restarted to recover
+	float load;         // CPU load in %, averaged over recent blocks
+	float loadPeak;     // highest load of a single block in %
+}EngineStats;
+
+/**
+ * @brief Initialise the engine with the
+ *        effects it should run, one after
+ *        another in table order. Its buffers
+ *        come from the arenas, call arena_init()
+ *        first. Stops in Error_Handler() if they
+ *        don't fit.
+ *
+ * @param effects Table of effects to process,
+ *        NULL to play straight through until
+ *        engine_setOrder() hands some over
+ * @param effectNum Number of effects in the table
+ *
+ * @retval None
+ */
+void engine_init(Effect** effects, int effectNum);
+
+/**
+ * @brief Change the order effects are run in.
+ *        Takes effect before the next block.
+ *
+ * @param effects Table of effects to process
+ * @param effectNum Number of effects in the table
+ *
+ * @retval None
+ */
+void engine_setOrder(Effect** effects, int effectNum);
+
+/**
+ * @brief Route the effects through a graph,
+ *        for parallel paths. The graph is
+ *        copied, and takes effect before the
+ *        next block. If it needs too many
+ *        buffers the old routing is kept.
+ *
+ * @param graph The routing graph
+ *
+ * @retval None
+ */
+void engine_setRoute(const RouteGraph* graph);
+
+/**
+ * @brief Recompile the routing, call this when
+ *        an effect is turned on or off. Takes
+ *        effect before the next block.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_updateChain(void);
+
+/**
+ * @brief Turn the fused kernels on or off, off
+ *        runs every effect in its own pass.
+ *        Takes effect before the next block.
+ *        They start on in the float build and
+ *        off in the Q15 build.
+ *
+ * @param on 1 to fuse, 0 not to
+ *
+ * @retval None
+ */
+void engine_setFusedKernels(int on);
+
+/**
+ * @brief Start the codec and the record
+ *        and playback DMA streams.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_start(void);
+
+/**
+ * @brief Process every block the DMA
+ *        callbacks have queued, oldest first.
+ *
+ * @param None
+ *
+ * @retval Number of blocks processed
+ */
+int engine_service(void);
+
+/**
+ * @brief Copy out the engine counters.
+ *
+ * @param stats Where to put the counters
+ *
+ * @retval None
+ */
+void engine_getStats(EngineStats* stats);
+
+/**
+ * @brief Start the peak load again, so it
+ *        shows the peak from now on.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_resetLoadPeak(void);
+
+/**
+ * @brief Copy out the cycles an effect or
+ *        the whole block has taken.
+ *
+ * @param effect The effect, NULL for the block
+ * @param stats Where to put them
+ *
+ * @retval None
+ */
+void engine_getProfile(const Effect* effect, ProfileStats* stats);
+
+/**
+ * @brief Start the profile of the block
+ *        and every effect in the routing
+ *        again, so it shows from now on.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_resetProfile(void);
+
+/**
+ * @brief Print the block profile and the
+ *        profile of each effect in the routing.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void engine_printProfile(void);
+
+/**
+ * @brief Ask for a new block size, it is
+ *        switched over between blocks.
+ *
+ * @param frames Frames per block, a power of 2
+ *        between AUDIO_BLOCK_FRAMES_MIN and
+ *        AUDIO_BLOCK_FRAMES_MAX
+ *
+ * @retval None
+ */
+void engine_setBlockFrames(uint32_t frames);
+
+/**
+ * @brief Block size the engine has been
+ *        asked for, this is what the
+ *        latency menu shows.
+ *
+ * @param None
+ *
+ * @retval Frames per block
+ */
+uint32_t engine_getBlockFrames(void);
+
+/**
+ * @brief Ask for a new sample rate, it is
+ *        switched over between blocks.
+ *
+ * @param rate 44100, 48000 or 96000
+ *
+ * @retval None
+ */
+void engine_setSampleRate(uint32_t rate);
+
+/**
+ * @brief Sample rate the engine has been
+ *        asked for, this is what the
+ *        latency menu shows.
+ *
+ * @param None
+ *
+ * @retval Sample rate
+ */
+uint32_t engine_getSampleRate(void);
+
+/**
+ * @brief Ask for a new codec volume, the audio
+ *        task sets it before the next block.
+ *        It is put back when the streams restart.
+ *
+ * @param newVolume Volume 0 to 100
+ *
+ * @retval None
+ */
+void engine_setVolume(uint8_t newVolume);
+
+#endif
@@ -16,89 +16,193 @@
  * y(n) = x(n) + x(n-(1+(maxDelay*abs(lfoDepth*lfo(n))))
  * ------------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
 #include "flanger.h"
 
 // parameters used
-static float parameterValues[3];
 static Parameter paramRate  = {"Rate[Hz] ",  0.1f, 0.1f,  1.0f}; // 0 to 1 hz
 static Parameter paramDepth = {"Depth[%] ", 10.0f, 0.0f,  100.0f}; // 0 to 100 %
 static Parameter paramDelay = {"Delay[ms]",  1.0f, 0.0f,  15.0f}; // 0 to 15ms
 static Parameter parameters[3];
-Effect flanger;
 
 
 /**
  *
- * @brief This function intialized the global
- *        flanger struct, this must be called
- *        before usage.
+ * @brief Set up a new flanger in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @param None
+ * @param effect The effect object to set up
  *
- * @retval None
+ * @retval 0 on success, -1 if an arena is out of budget
  *
  */
-void flanger_init(void)
+int flanger_create(Effect* effect)
 {
+	// 15ms of sweep at 96kHz is 1440 frames,
+	// small enough for SRAM1
+	frame_t* buffer = arena_alloc(ARENA_SRAM1, FLANGER_LINE_SIZE*sizeof(frame_t), ARENA_ALIGN_CACHE);
+	if(buffer == NULL)
+		return -1;
+
+	// the lfo phase moves on every frame, so
+	// its state is worth keeping in DTCM
+	FlangerState* s = arena_alloc(ARENA_DTCM, sizeof(FlangerState), ARENA_ALIGN);
+	float* values = arena_alloc(ARENA_SRAM1, 3*sizeof(float), ARENA_ALIGN);
+	if(s == NULL || values == NULL)
+		return -1;
+
 	// init params
 	parameters[0] = paramRate;
 	parameters[1] = paramDepth;
 	parameters[2] = paramDelay;
 
-	parameterValues[0] = 0.5f;
-	parameterValues[1] = 50.0f;
-	parameterValues[2] = 2.0f;
+	values[0] = 0.5f;
+	values[1] = 50.0f;
+	values[2] = 2.0f;
+
+	// init state
+	s->params = effect->audioValues;
+	s->phase = 0;
+	delayline_init(&s->line, buffer, FLANGER_LINE_SIZE);
 
 	// init effect object
-	strcpy( flanger.name, "Flanger" );
-	flanger.on = 0;
-	flanger.currentParam = 0;
-	flanger.paramNum = 3;
-	flanger.parameters = parameters;
-	flanger.processBuffer = flanger_processBuffer;
-	flanger.paramValues = parameterValues;
+	strcpy( effect->name, "Flanger" );
+	effect->on = 0;
+	effect->currentParam = 0;
+	effect->paramNum = 3;
+	effect->parameters = parameters;
+	effect->prepare = flanger_prepare;
+	effect->reset = flanger_reset;
+	effect->type = EFFECT_FLANGER;
+	effect->processBuffer = flanger_processBuffer;
+	effect->paramValues = values;
+	effect->state = s;
+
+	// audio loop picks these up before the first block
+	mailbox_init(&effect->mailbox);
+	effect_postParams(effect);
+
+	return 0;
+}
+
+/**
+ * @brief Work out the delay range and lfo
+ *        step from the parameters. Called by
+ *        the engine when the parameters change.
+ *
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ *
+ * @retval None
+ *
+ */
+void flanger_prepare(void* state, uint32_t sampleRate)
+{
+	FlangerState* s = (FlangerState*)state;
+
+	s->maxDelay = ((s->params[2])*sampleRate)/1000;
+
+#if AUDIO_FIXED_POINT
+	s->phaseStep = dsp_phase_step(s->params[0], sampleRate);
+	s->lfoDepth = dsp_float_to_q15(s->params[1]/100.0f);
+#else
+	s->phaseStep = s->params[0] / sampleRate;
+	s->lfoDepth = (s->params[1]/100.0f);
+#endif
+}
+
+/**
+ * @brief Clear the line and lfo phase so the
+ *        flanger starts from silence.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
+ *
+ * @retval None
+ *
+ */
+void flanger_reset(void* state)
+{
+	FlangerState* s = (FlangerState*)state;
+
+	delayline_clear(&s->line);
+	s->phase = 0;
 }
 
 /**
  * @brief This function applies the flanger effect
  *        to the input buffer.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void flanger_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset)
+AUDIO_ITCM void flanger_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames)
 {
-	if(flanger.on)
+	FlangerState* s = (FlangerState*)state;
+	uint16_t maxDelay = s->maxDelay;
+
+#if AUDIO_FIXED_POINT
+	uint32_t phase = s->phase;
+	uint32_t phaseStep = s->phaseStep;
+	q15_t lfoDepth = s->lfoDepth;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		// get current frame
+		frame_t frame = inputData[i];
+		delayline_write(&s->line, frame);
+
+		// get the modulated delay, lfo is -1 to 1 so
+		// (1 - lfo) is 0 to 2, 0 to 65536 in Q15. that's
+		// past a q15_t so it's kept in an int32_t, and
+		// maxDelay/2 is under 32768 so the product stays
+		// under 2^31
+		int32_t sweep = 32768 - dsp_mul_q15(lfoDepth, dsp_cos_q15(phase));
+		uint16_t delaySamples = (uint16_t)(1 + (((maxDelay/2) * sweep) >> 15));
+
+		// get the delayed frame
+		frame_t prevFrame = delayline_read(&s->line, delaySamples);
+
+		// send to output, halving can't overflow
+		outputData[i] = dsp_avg2(frame, prevFrame);
+
+		// update phase, wraps by itself
+		phase += phaseStep;
+	}
+#else
+	float phase = s->phase;
+	float phaseStep = s->phaseStep;
+	float lfoDepth = s->lfoDepth;
+
+	for(uint32_t i = 0; i < frames; i++)
 	{
-		static float phase = 0;
-		uint16_t maxDelay  = ((parameterValues[2])*44100)/1000;
-		float lfoFreq = parameterValues[0];
-		float lfoDepth = (parameterValues[1]/100.0f);
+		// get current frame
+		frame_t frame = inputData[i];
+		delayline_write(&s->line, frame);
 
-		for(int i = offset; i < offset+(AUDIO_BLOCK_SIZE/2); i++)
-		{
-			// get current sample
-			int16_t sample = (int16_t)outputData[i];
+		// get the modulated delay
+		uint16_t delaySamples = (uint16_t)(1+(maxDelay/2)*(1-(lfoDepth * arm_cos_f32(2*PI*phase))));
 
-			// get the modulated delay
-			uint16_t delaySamples = (uint16_t)(1+(maxDelay/2)*(1-(lfoDepth * arm_cos_f32(2*PI*phase))));
+		// get the delayed frame
+		frame_t prevFrame = delayline_read(&s->line, delaySamples);
 
-			// get the delayed sample
-			int16_t prevSample = (int16_t)inputData[(i + AUDIO_BUFFER_SIZE - delaySamples) % AUDIO_BUFFER_SIZE];
+		// send to output
+		outputData[i].l = (frame.l+prevFrame.l)*0.5f;
+		outputData[i].r = (frame.r+prevFrame.r)*0.5f;
 
-			// send to output
-			outputData[i] = (uint16_t) ((sample+prevSample)/2);
+		// update phase
+		phase =  fmodf(phase + phaseStep,1);
+	}
+#endif
 
-			// update phase
-			phase =  fmodf(phase + lfoFreq / 44100,1);
-		}
-	 }
+	s->phase = phase;
 }
@@ -16,7 +16,7 @@
  * y(n) = x(n) + x(n-(1+(maxDelay*abs(lfoDepth*lfo(n))))
  * ------------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -27,34 +27,86 @@
 #include "arm_math.h"
 #include "arm_common_tables.h"
 #include "effect.h"
+#include "delayline.h"
 
+// 15ms of history at 96khz, rounded up to a power of 2
+#define FLANGER_LINE_SIZE ((uint32_t)2048)
 
-extern Effect flanger;
+/**
+ * @brief State for a flanger,
+ *        the line holds previous input
+ */
+typedef struct
+{
+	const float* params;
+	DelayLine line;
+#if AUDIO_FIXED_POINT
+	uint32_t phase; // a full turn is 2^32
+#else
+	float phase;
+#endif
+
+	// worked out by flanger_prepare()
+	uint16_t maxDelay;
+#if AUDIO_FIXED_POINT
+	uint32_t phaseStep;
+	q15_t lfoDepth;
+#else
+	float phaseStep;
+	float lfoDepth;
+#endif
+}FlangerState;
+
+/**
+ *
+ * @brief Set up a new flanger in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
+ *
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
+ *
+ */
+int flanger_create(Effect* effect);
 
 /**
+ * @brief Work out the delay range and lfo
+ *        step from the parameters. Called by
+ *        the engine when the parameters change.
  *
- * @brief This function intialized the global
- *        flanger struct, this must be called
- *        before usage.
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ *
+ * @retval None
+ *
+ */
+void flanger_prepare(void* state, uint32_t sampleRate);
+
+/**
+ * @brief Clear the line and lfo phase so the
+ *        flanger starts from silence.
+ *        Called before it is turned back on.
  *
- * @param None
+ * @param state The effects state
  *
  * @retval None
  *
  */
-void flanger_init(void);
+void flanger_reset(void* state);
 
 /**
  * @brief This function applies the flanger effect
  *        to the input buffer.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void flanger_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset);
+void flanger_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames);
 
 #endif
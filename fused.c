@@ -0,0 +1,225 @@
+/**
+ * ========================
+ * File: fused.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Fused kernels. Effects
+ * that only work a frame at a
+ * time (distortion, tremolo and
+ * the wahwah filter) can run
+ * one after another in a single
+ * pass over the block, so the
+ * frame stays in registers in
+ * between instead of going back
+ * out to the block buffer.
+ *
+ * Each kernel is built from the
+ * effects *_frame() functions,
+ * so it gives exactly what the
+ * effects would one at a time.
+ * Each kernel works on copies of
+ * the state for the block and
+ * writes back what moved.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "fused.h"
+#include "registry.h"
+
+/**
+ * @brief The effects each kernel runs, in order
+ */
+typedef struct
+{
+	FusedKernel kernel;
+	int stageNum;
+	EffectType types[FUSED_STAGES_MAX];
+}FusedEntry;
+
+static const FusedEntry fused_table[] =
+{
+	{FUSED_WAHWAH_DISTORTION,         2, {EFFECT_WAHWAH, EFFECT_DISTORTION}},
+	{FUSED_WAHWAH_TREMOLO,            2, {EFFECT_WAHWAH, EFFECT_TREMOLO}},
+	{FUSED_DISTORTION_TREMOLO,        2, {EFFECT_DISTORTION, EFFECT_TREMOLO}},
+	{FUSED_WAHWAH_DISTORTION_TREMOLO, 3, {EFFECT_WAHWAH, EFFECT_DISTORTION, EFFECT_TREMOLO}},
+};
+
+#define FUSED_TABLE_SIZE (sizeof(fused_table)/sizeof(fused_table[0]))
+
+/**
+ * @brief Can this effect be part of a fused kernel.
+ *
+ * @param effect The effect
+ *
+ * @retval 1 if it can, 0 if not
+ */
+int fused_canFuse(const Effect* effect)
+{
+	return effect->type == EFFECT_WAHWAH
+	    || effect->type == EFFECT_DISTORTION
+	    || effect->type == EFFECT_TREMOLO;
+}
+
+/**
+ * @brief Find the kernel that runs these
+ *        effects, in this order.
+ *
+ * @param effects The effects
+ * @param effectNum Number of effects
+ *
+ * @retval The kernel, FUSED_NONE if there isn't one
+ */
+FusedKernel fused_find(Effect* const* effects, int effectNum)
+{
+	for(uint32_t i = 0; i < FUSED_TABLE_SIZE; i++)
+	{
+		const FusedEntry* entry = &fused_table[i];
+		int match = entry->stageNum == effectNum;
+
+		for(int j = 0; match && j < effectNum; j++)
+			match = effects[j]->type == entry->types[j];
+
+		if(match)
+			return entry->kernel;
+	}
+
+	return FUSED_NONE;
+}
+
+/**
+ * @brief Wahwah then distortion.
+ *
+ * @param effects The effects
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void fused_wahwahDistortion(Effect* const* effects, const frame_t* in, frame_t* out, uint32_t frames)
+{
+	WahWahState* wah = (WahWahState*)effects[0]->state;
+	WahWahVoice voice = wah->voice;
+	const DistortionState dist = *(const DistortionState*)effects[1]->state;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		frame_t x = wahwah_frame(wah, &voice, in[i]);
+		out[i] = distortion_frame(&dist, x);
+	}
+
+	wah->voice = voice;
+}
+
+/**
+ * @brief Wahwah then tremolo.
+ *
+ * @param effects The effects
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void fused_wahwahTremolo(Effect* const* effects, const frame_t* in, frame_t* out, uint32_t frames)
+{
+	WahWahState* wah = (WahWahState*)effects[0]->state;
+	WahWahVoice voice = wah->voice;
+	TremoloState trem = *(TremoloState*)effects[1]->state;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		frame_t x = wahwah_frame(wah, &voice, in[i]);
+		out[i] = tremolo_frame(&trem, &trem.phase, x);
+	}
+
+	wah->voice = voice;
+	((TremoloState*)effects[1]->state)->phase = trem.phase;
+}
+
+/**
+ * @brief Distortion then tremolo.
+ *
+ * @param effects The effects
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void fused_distortionTremolo(Effect* const* effects, const frame_t* in, frame_t* out, uint32_t frames)
+{
+	const DistortionState dist = *(const DistortionState*)effects[0]->state;
+	TremoloState trem = *(TremoloState*)effects[1]->state;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		frame_t x = distortion_frame(&dist, in[i]);
+		out[i] = tremolo_frame(&trem, &trem.phase, x);
+	}
+
+	((TremoloState*)effects[1]->state)->phase = trem.phase;
+}
+
+/**
+ * @brief Wahwah, distortion then tremolo.
+ *
+ * @param effects The effects
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+static AUDIO_ITCM void fused_wahwahDistortionTremolo(Effect* const* effects, const frame_t* in, frame_t* out, uint32_t frames)
+{
+	WahWahState* wah = (WahWahState*)effects[0]->state;
+	WahWahVoice voice = wah->voice;
+	const DistortionState dist = *(const DistortionState*)effects[1]->state;
+	TremoloState trem = *(TremoloState*)effects[2]->state;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		frame_t x = wahwah_frame(wah, &voice, in[i]);
+		x = distortion_frame(&dist, x);
+		out[i] = tremolo_frame(&trem, &trem.phase, x);
+	}
+
+	wah->voice = voice;
+	((TremoloState*)effects[2]->state)->phase = trem.phase;
+}
+
+/**
+ * @brief Run a fused kernel over a block.
+ *
+ * @param kernel The kernel from fused_find()
+ * @param effects The effects it was found for
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+AUDIO_ITCM void fused_run(FusedKernel kernel, Effect* const* effects, const frame_t* in, frame_t* out, uint32_t frames)
+{
+	switch(kernel)
+	{
+	case FUSED_WAHWAH_DISTORTION:
+		fused_wahwahDistortion(effects, in, out, frames);
+		break;
+	case FUSED_WAHWAH_TREMOLO:
+		fused_wahwahTremolo(effects, in, out, frames);
+		break;
+	case FUSED_DISTORTION_TREMOLO:
+		fused_distortionTremolo(effects, in, out, frames);
+		break;
+	case FUSED_WAHWAH_DISTORTION_TREMOLO:
+		fused_wahwahDistortionTremolo(effects, in, out, frames);
+		break;
+	default:
+		break;
+	}
+}
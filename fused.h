@@ -0,0 +1,81 @@
+/**
+ * ========================
+ * File: fused.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Fused kernels. Effects
+ * that only work a frame at a
+ * time (distortion, tremolo and
+ * the wahwah filter) can run
+ * one after another in a single
+ * pass over the block, so the
+ * frame stays in registers in
+ * between instead of going back
+ * out to the block buffer.
+ *
+ * There is a kernel for each of
+ * the common runs of them. The
+ * routing swaps a run for its
+ * fused kernel when it compiles.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __FUSED_H
+#define __FUSED_H
+
+#include "main.h"
+#include "effect.h"
+
+// most effects one fused kernel runs
+#define FUSED_STAGES_MAX 3
+
+/**
+ * @brief The fused kernels, named for
+ *        the effects they run in order
+ */
+typedef enum
+{
+	FUSED_NONE = 0,
+	FUSED_WAHWAH_DISTORTION,
+	FUSED_WAHWAH_TREMOLO,
+	FUSED_DISTORTION_TREMOLO,
+	FUSED_WAHWAH_DISTORTION_TREMOLO,
+}FusedKernel;
+
+/**
+ * @brief Can this effect be part of a fused kernel.
+ *
+ * @param effect The effect
+ *
+ * @retval 1 if it can, 0 if not
+ */
+int fused_canFuse(const Effect* effect);
+
+/**
+ * @brief Find the kernel that runs these
+ *        effects, in this order.
+ *
+ * @param effects The effects
+ * @param effectNum Number of effects
+ *
+ * @retval The kernel, FUSED_NONE if there isn't one
+ */
+FusedKernel fused_find(Effect* const* effects, int effectNum);
+
+/**
+ * @brief Run a fused kernel over a block.
+ *
+ * @param kernel The kernel from fused_find()
+ * @param effects The effects it was found for
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+void fused_run(FusedKernel kernel, Effect* const* effects, const frame_t* in, frame_t* out, uint32_t frames);
+
+#endif
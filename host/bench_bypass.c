@@ -0,0 +1,129 @@
+/**
+ * ========================
+ * File: bench_bypass.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Times the engine's block
+ * with the delay on, with it
+ * turned off and its echoes
+ * ringing out, and once they
+ * have and every effect is off,
+ * where the block is copied
+ * straight through. The last is
+ * the same path the bypass took
+ * before tails were rung out.
+ * Also gives how long the tail
+ * rang for. Gives the table in
+ * the README.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+
+// half transfers timed with the delay on
+// and with everything bypassed
+#define BYPASS_STEPS 2000
+
+// longest the tail is given to ring out
+#define BYPASS_TAIL_MAX 20000
+
+static uint32_t source_pos;
+static int source_on;
+
+/**
+ * @brief A sine on the left channel while
+ *        playing, silence after.
+ *
+ * @param samples Where to put them
+ * @param count Number of samples
+ *
+ * @retval None
+ */
+static void bypass_source(int16_t* samples, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i += 2)
+	{
+		float t = source_pos++;
+		samples[i] = source_on ? (int16_t)(8000*sinf(t*0.05f)) : 0;
+		samples[i+1] = 0;
+	}
+}
+
+/**
+ * @brief Print the block times so far and
+ *        start them again.
+ *
+ * @param name Which path
+ *
+ * @retval None
+ */
+static void bypass_print(const char* name)
+{
+	ProfileStats stats;
+
+	engine_getProfile(NULL, &stats);
+	printf("%-12s %8u %8u %8u\n", name, stats.count, stats.min, profile_average(&stats));
+	engine_resetProfile();
+}
+
+int main(void)
+{
+	EngineStats stats;
+	uint32_t steps = 0;
+
+	arena_init();
+	registry_init();
+
+	engine_init(registry_effects, EFFECT_NUM);
+	engine_start();
+	hostsim_audio_setSource(bypass_source);
+
+	printf("%-12s %8s %8s %8s\n", "Path", "Blocks", "Min", "Average");
+
+	source_on = 1;
+	registry_effects[EFFECT_DELAY]->on = 1;
+	engine_updateChain();
+	engine_resetProfile();
+
+	for(int i = 0; i < BYPASS_STEPS; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+	bypass_print("delay on");
+
+	// stop playing as the delay goes off,
+	// what's left is its echoes
+	source_on = 0;
+	registry_effects[EFFECT_DELAY]->on = 0;
+	engine_updateChain();
+	engine_getStats(&stats);
+	uint32_t bypassed = stats.bypassed;
+
+	while(stats.bypassed == bypassed && steps < BYPASS_TAIL_MAX)
+	{
+		hostsim_dma_step();
+		engine_service();
+		engine_getStats(&stats);
+		steps++;
+	}
+	bypass_print("delay tail");
+
+	for(int i = 0; i < BYPASS_STEPS; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+	bypass_print("bypass");
+
+	printf("tail rang out over %u ms, block times in cycles\n",
+			(unsigned)((uint64_t)steps * engine_getBlockFrames() * 1000 / engine_getSampleRate()));
+
+	return 0;
+}
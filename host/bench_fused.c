@@ -0,0 +1,156 @@
+/**
+ * ========================
+ * File: bench_fused.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Times the fused kernels
+ * against running the same
+ * effects one pass each. Both
+ * schedules are compiled from
+ * the same routing, one of them
+ * goes through route_fuse().
+ * Gives the table in the README.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "registry.h"
+#include "route.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_FRAMES 128
+
+// blocks timed in a run, best run is kept
+#define BENCH_BLOCKS 2000
+#define BENCH_RUNS 80
+
+/**
+ * @brief A run of effects with a fused kernel
+ */
+typedef struct
+{
+	const char* name;
+	uint32_t effects; // bit for each EffectType
+}BenchChain;
+
+static const BenchChain bench_chains[] =
+{
+	{"WahWah -> Distortion",  (1u << EFFECT_WAHWAH) | (1u << EFFECT_DISTORTION)},
+	{"WahWah -> Tremolo",     (1u << EFFECT_WAHWAH) | (1u << EFFECT_TREMOLO)},
+	{"Distortion -> Tremolo", (1u << EFFECT_DISTORTION) | (1u << EFFECT_TREMOLO)},
+	{"All three",             (1u << EFFECT_WAHWAH) | (1u << EFFECT_DISTORTION) | (1u << EFFECT_TREMOLO)},
+};
+
+#define BENCH_CHAIN_NUM (sizeof(bench_chains)/sizeof(bench_chains[0]))
+
+static frame_t bench_source[BENCH_FRAMES];
+static frame_t bench_blocks[ROUTE_BUFFERS_MAX][BENCH_FRAMES];
+static frame_t* bench_buffers[ROUTE_BUFFERS_MAX];
+
+/**
+ * @brief CPU time of this thread.
+ *
+ * @param None
+ *
+ * @retval Time in ns
+ */
+static double bench_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec*1e9 + now.tv_nsec;
+}
+
+/**
+ * @brief Time a schedule over a run of blocks.
+ *        Each block starts from the same input,
+ *        running the last output again would
+ *        fade it into denormals in float.
+ *
+ * @param schedule The compiled routing
+ *
+ * @retval Time per block in ns
+ */
+static double bench_run(const RouteSchedule* schedule)
+{
+	double start = bench_now();
+
+	for(int i = 0; i < BENCH_BLOCKS; i++)
+	{
+		memcpy(bench_blocks[0], bench_source, sizeof(bench_source));
+		route_run(schedule, bench_buffers, BENCH_FRAMES);
+	}
+
+	return (bench_now() - start) / BENCH_BLOCKS;
+}
+
+int main(void)
+{
+	arena_init();
+	registry_init();
+
+	for(int i = 0; i < ROUTE_BUFFERS_MAX; i++)
+		bench_buffers[i] = bench_blocks[i];
+
+	for(int i = 0; i < BENCH_FRAMES; i++)
+	{
+		float x = 0.3f*sinf(i*0.05f);
+#if AUDIO_FIXED_POINT
+		bench_source[i] = dsp_pack(dsp_float_to_q15(x), dsp_float_to_q15(x));
+#else
+		bench_source[i].l = x;
+		bench_source[i].r = x;
+#endif
+	}
+
+	for(int i = 0; i < EFFECT_NUM; i++)
+	{
+		Effect* effect = registry_effects[i];
+		if(effect == NULL)
+			continue;
+
+		mailbox_fetch(&effect->mailbox, effect->audioValues, effect->paramNum);
+		if(effect->prepare)
+			effect->prepare(effect->state, AUDIO_SAMPLE_RATE_DEFAULT);
+	}
+
+	printf("%-22s %10s %10s\n", "Effects", "Separate", "Fused");
+
+	for(uint32_t c = 0; c < BENCH_CHAIN_NUM; c++)
+	{
+		RouteGraph graph;
+		RouteSchedule separate, fused;
+		double separateBest = 1e30;
+		double fusedBest = 1e30;
+
+		for(int i = 0; i < EFFECT_NUM; i++)
+			if(registry_effects[i])
+				registry_effects[i]->on = (bench_chains[c].effects >> i) & 1;
+
+		route_serial(&graph, registry_effects, EFFECT_NUM);
+		if(route_compile(&graph, &separate) < 0)
+			return 1;
+		fused = separate;
+		route_fuse(&fused);
+
+		// take turns so both see the same load on the host
+		for(int run = 0; run < BENCH_RUNS; run++)
+		{
+			double time = bench_run(&separate);
+			if(time < separateBest)
+				separateBest = time;
+
+			time = bench_run(&fused);
+			if(time < fusedBest)
+				fusedBest = time;
+		}
+
+		printf("%-22s %7.0f ns %7.0f ns\n", bench_chains[c].name, separateBest, fusedBest);
+	}
+
+	return 0;
+}
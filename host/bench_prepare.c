@@ -0,0 +1,135 @@
+/**
+ * ========================
+ * File: bench_prepare.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Times each effect on a
+ * 256 frame block, with prepare
+ * run once up front like the
+ * engine does, and with prepare
+ * run before every block. The
+ * difference is what caching
+ * the worked out values saves.
+ * Gives the table in the README.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "registry.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_FRAMES 256
+
+// blocks timed in a run, best run is kept
+#define BENCH_BLOCKS 2000
+#define BENCH_RUNS 80
+
+/**
+ * @brief CPU time of this thread.
+ *
+ * @param None
+ *
+ * @retval Time in ns
+ */
+static double bench_now(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec*1e9 + now.tv_nsec;
+}
+
+/**
+ * @brief Time an effect over a run of blocks.
+ *
+ * @param effect The effect
+ * @param source Block to start each one from
+ * @param prepare 1 to prepare before every block
+ *
+ * @retval Time per block in ns
+ */
+static double bench_run(Effect* effect, const frame_t* source, int prepare)
+{
+	static frame_t block[BENCH_FRAMES];
+	double start = bench_now();
+
+	for(int i = 0; i < BENCH_BLOCKS; i++)
+	{
+		memcpy(block, source, sizeof(block));
+		if(prepare)
+			effect->prepare(effect->state, AUDIO_SAMPLE_RATE_DEFAULT);
+		registry_process(effect, block, block, BENCH_FRAMES);
+	}
+
+	return (bench_now() - start) / BENCH_BLOCKS;
+}
+
+/**
+ * @brief Time an effect on a block, prepared
+ *        once and prepared every block. The
+ *        runs take turns so both see the same
+ *        load on the host.
+ *
+ * @param effect The effect
+ * @param once Best time prepared once, in ns
+ * @param every Best time prepared every block, in ns
+ *
+ * @retval None
+ */
+static void bench_effect(Effect* effect, double* once, double* every)
+{
+	static frame_t source[BENCH_FRAMES];
+
+	for(int i = 0; i < BENCH_FRAMES; i++)
+	{
+		float x = 0.3f*sinf(i*0.05f);
+#if AUDIO_FIXED_POINT
+		source[i] = dsp_pack(dsp_float_to_q15(x), dsp_float_to_q15(x));
+#else
+		source[i].l = x;
+		source[i].r = x;
+#endif
+	}
+
+	*once = 1e30;
+	*every = 1e30;
+
+	for(int run = 0; run < BENCH_RUNS; run++)
+	{
+		double time = bench_run(effect, source, 0);
+		if(time < *once)
+			*once = time;
+
+		time = bench_run(effect, source, 1);
+		if(time < *every)
+			*every = time;
+	}
+}
+
+int main(void)
+{
+	arena_init();
+	registry_init();
+
+	printf("%-10s %14s %14s\n", "Effect", "Prepared once", "Every block");
+
+	for(int i = 0; i < EFFECT_NUM; i++)
+	{
+		Effect* effect = registry_effects[i];
+		if(effect == NULL || effect->prepare == NULL)
+			continue;
+
+		mailbox_fetch(&effect->mailbox, effect->audioValues, effect->paramNum);
+		effect->prepare(effect->state, AUDIO_SAMPLE_RATE_DEFAULT);
+
+		double once, every;
+		bench_effect(effect, &once, &every);
+
+		printf("%-10s %11.0f ns %11.0f ns\n", effect->name, once, every);
+	}
+
+	return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * ========================
+ * File: bench_report.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Prints the reports the
+ * board prints, from a host run.
+ * Comes up in the same order as
+ * main(), with nothing to do for
+ * the display and UI phases, and
+ * prints the boot times and the
+ * memory budget. Then streams
+ * blocks with the WahWah and
+ * Flanger on and prints their
+ * profile. Gives the tables in
+ * the README.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "boot.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+
+// half transfers to profile
+#define REPORT_STEPS 2000
+
+int main(void)
+{
+	boot_start();
+	boot_mark(BOOT_CLOCKS);
+
+	arena_init();
+	trace_init();
+	boot_mark(BOOT_MEMORY);
+
+	// straight through, the first block
+	// played is the first audio
+	engine_init(NULL, 0);
+	engine_start();
+	hostsim_dma_step();
+	engine_service();
+	boot_firstAudio();
+	boot_mark(BOOT_AUDIO);
+
+	// no LCD or touch screen on the host
+	boot_mark(BOOT_DISPLAY);
+
+	registry_init();
+	engine_setOrder(registry_effects, EFFECT_NUM);
+	boot_mark(BOOT_EFFECTS);
+
+	boot_mark(BOOT_UI);
+
+	arena_report();
+	boot_report();
+
+	registry_effects[EFFECT_WAHWAH]->on = 1;
+	registry_effects[EFFECT_FLANGER]->on = 1;
+	engine_updateChain();
+	engine_resetProfile();
+
+	for(int i = 0; i < REPORT_STEPS; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+
+	engine_printProfile();
+	return 0;
+}
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""
+========================
+File: check_trace.py
+
+Author: Joseph Kenyon
+
+Desc: Checks the Chrome trace
+JSON tools/trace_json.py made
+from a host trace dump. It has
+to load, have blocks in it, and
+every begin on a track has to
+be ended by an end with the
+same name, in order.
+
+  python3 check_trace.py trace.json
+
+Last Updated: 16/10/2026
+
+========================
+"""
+import json
+import sys
+
+
+def check(trace):
+    """what's wrong with the trace, None if nothing"""
+    events = trace["traceEvents"]
+    open_spans = {}
+    spans = {}
+
+    for event in events:
+        kind = event["ph"]
+        stack = open_spans.setdefault(event["tid"], [])
+
+        if kind == "B":
+            stack.append(event["name"])
+        elif kind == "E":
+            if not stack:
+                return "end of %s with nothing begun on track %d" % (event["name"], event["tid"])
+            name = stack.pop()
+            if name != event["name"]:
+                return "end of %s inside %s on track %d" % (event["name"], name, event["tid"])
+            spans[name] = spans.get(name, 0) + 1
+
+    for tid, stack in open_spans.items():
+        if stack:
+            return "%s never ended on track %d" % (stack[-1], tid)
+
+    for name in ("block", "volume i2c"):
+        if not spans.get(name):
+            return "no %s spans" % name
+
+    print("%d events, %d blocks, %d lost" % (len(events), spans["block"], trace["otherData"]["lost"]))
+    return None
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: check_trace.py <trace json>")
+        return 2
+
+    with open(sys.argv[1]) as f:
+        trace = json.load(f)
+
+    problem = check(trace)
+    if problem:
+        print("FAIL %s" % problem)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,135 @@
+/**
+ * ========================
+ * File: test_cache.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Checks the engine keeps
+ * the DMA buffers in step with
+ * the cache. Streams blocks with
+ * every effect on and expects
+ * hostsim_cache_stale() to stay
+ * at 0. Then does it again with
+ * the invalidates skipped and
+ * with the cleans skipped, and
+ * expects stale data both times,
+ * so we know the check works.
+ *
+ * Linked with --wrap on the two
+ * SCB_ functions so they can be
+ * skipped. Each case runs in a
+ * process of its own, so each
+ * starts from fresh arenas.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+
+// half transfers to stream, about 3s
+#define CACHE_STEPS 1000
+
+/**
+ * @brief Which cache operation to skip
+ */
+typedef enum
+{
+	CACHE_SKIP_NONE,
+	CACHE_SKIP_INVALIDATE,
+	CACHE_SKIP_CLEAN,
+	CACHE_SKIP_NUM,
+}CacheSkip;
+
+static const char* cache_names[CACHE_SKIP_NUM] =
+{
+	[CACHE_SKIP_NONE]       = "none",
+	[CACHE_SKIP_INVALIDATE] = "invalidate",
+	[CACHE_SKIP_CLEAN]      = "clean",
+};
+
+static CacheSkip cache_skip;
+static uint32_t source_pos;
+
+void __real_SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t dsize);
+void __real_SCB_CleanDCache_by_Addr(uint32_t* addr, int32_t dsize);
+
+void __wrap_SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t dsize)
+{
+	if(cache_skip != CACHE_SKIP_INVALIDATE)
+		__real_SCB_InvalidateDCache_by_Addr(addr, dsize);
+}
+
+void __wrap_SCB_CleanDCache_by_Addr(uint32_t* addr, int32_t dsize)
+{
+	if(cache_skip != CACHE_SKIP_CLEAN)
+		__real_SCB_CleanDCache_by_Addr(addr, dsize);
+}
+
+/**
+ * @brief A sine on the left channel, so
+ *        the played blocks aren't all 0.
+ *
+ * @param samples Where to put them
+ * @param count Number of samples
+ *
+ * @retval None
+ */
+static void cache_source(int16_t* samples, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i += 2)
+	{
+		float t = source_pos++;
+		samples[i] = (int16_t)(8000*sinf(t*0.05f));
+		samples[i+1] = 0;
+	}
+}
+
+/**
+ * @brief Stream blocks with every effect on,
+ *        skipping one cache operation.
+ *
+ * @param skip The operation to skip, a CacheSkip
+ *
+ * @retval 0 if it went as expected, 1 if not
+ */
+static int cache_case(int skip)
+{
+	arena_init();
+	registry_init();
+
+	for(int i = 0; i < EFFECT_NUM; i++)
+		if(registry_effects[i])
+			registry_effects[i]->on = 1;
+
+	cache_skip = (CacheSkip)skip;
+
+	engine_init(registry_effects, EFFECT_NUM);
+	engine_start();
+	hostsim_audio_setSource(cache_source);
+
+	// the counter isn't reset by engine_start()
+	uint32_t start = hostsim_cache_stale();
+
+	for(int i = 0; i < CACHE_STEPS; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+
+	uint32_t stale = hostsim_cache_stale() - start;
+	int ok = (skip == CACHE_SKIP_NONE) ? stale == 0 : stale > 0;
+
+	printf("%-10s %8u%s\n", cache_names[skip], stale, ok ? "" : "  FAIL");
+	return !ok;
+}
+
+int main(void)
+{
+	printf("%-10s %8s\n", "Skipped", "Stale");
+
+	return hostsim_runIsolated(cache_case, CACHE_SKIP_NUM);
+}
@@ -0,0 +1,164 @@
+/**
+ * ========================
+ * File: test_recovery.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Checks the engine gets
+ * the streams going again after
+ * each fault the simulated DMA
+ * can make. Streams a while,
+ * makes the fault, then expects
+ * it counted in EngineStats, a
+ * restart counted, and blocks
+ * still being processed after.
+ *
+ * - a record SAI error
+ * - a playback SAI error
+ * - playback slipped a half
+ *   behind record
+ * - a dropped interrupt on
+ *   ENGINE_XRUN_RESTART blocks
+ *   in a row
+ *
+ * Each fault runs in a process of
+ * its own, so each starts from
+ * fresh arenas.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+#include <stddef.h>
+
+// half transfers to stream before the
+// fault and after the restart
+#define RECOVERY_STEPS 200
+
+// half transfers for the engine to see
+// the fault and restart
+#define RECOVERY_SETTLE 4
+
+/**
+ * @brief A fault, how to make it and the
+ *        counter it should show up in
+ */
+typedef struct
+{
+	const char* name;
+	HostSimFault fault;
+	uint32_t steps;   // DMA steps before the engine runs
+	uint32_t repeats; // times round, each followed by a block
+	size_t counter;   // offset of the counter in EngineStats
+}RecoveryCase;
+
+static const RecoveryCase recovery_cases[] =
+{
+	{"in error",  HOSTSIM_FAULT_IN_ERROR,  1, 1, offsetof(EngineStats, errors)},
+	{"out error", HOSTSIM_FAULT_OUT_ERROR, 1, 1, offsetof(EngineStats, errors)},
+	{"drift",     HOSTSIM_FAULT_DRIFT,     1, 1, offsetof(EngineStats, drifts)},
+	// the step after a dropped one is the same half
+	// again, so that block is lost
+	{"drop irq",  HOSTSIM_FAULT_DROP_IRQ,  2, ENGINE_XRUN_RESTART, offsetof(EngineStats, overruns)},
+};
+
+#define RECOVERY_CASE_NUM ((int)(sizeof(recovery_cases)/sizeof(recovery_cases[0])))
+
+/**
+ * @brief Read a counter out of the stats.
+ *
+ * @param stats The stats
+ * @param counter Offset of the counter
+ *
+ * @retval The count
+ */
+static uint32_t recovery_count(const EngineStats* stats, size_t counter)
+{
+	return *(const uint32_t*)((const char*)stats + counter);
+}
+
+/**
+ * @brief Step the DMA and let the engine
+ *        take each block as it comes.
+ *
+ * @param steps Number of half transfers
+ *
+ * @retval None
+ */
+static void recovery_stream(uint32_t steps)
+{
+	for(uint32_t i = 0; i < steps; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+}
+
+/**
+ * @brief Make one fault and check the engine
+ *        counts it and carries on.
+ *
+ * @param index The case
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int recovery_case(int index)
+{
+	const RecoveryCase* test = &recovery_cases[index];
+	EngineStats before, fault, after;
+
+	arena_init();
+	registry_init();
+
+	engine_init(registry_effects, EFFECT_NUM);
+	engine_start();
+	recovery_stream(RECOVERY_STEPS);
+	engine_getStats(&before);
+
+	for(uint32_t i = 0; i < test->repeats; i++)
+	{
+		hostsim_fault_inject(test->fault, 1);
+		for(uint32_t s = 0; s < test->steps; s++)
+			hostsim_dma_step();
+		engine_service();
+	}
+
+	// drift is only seen on the next block,
+	// and the restart when the engine runs
+	// after that
+	recovery_stream(RECOVERY_SETTLE);
+	engine_getStats(&fault);
+
+	recovery_stream(RECOVERY_STEPS);
+	engine_getStats(&after);
+
+	const char* failed = NULL;
+	if(recovery_count(&fault, test->counter) <= recovery_count(&before, test->counter))
+		failed = "fault not counted";
+	else if(fault.recoveries <= before.recoveries)
+		failed = "streams not restarted";
+	// a block can be missed while the streams
+	// start, never more than that
+	else if(after.blocks - fault.blocks < RECOVERY_STEPS - 1)
+		failed = "blocks stopped after the restart";
+	else if(after.recoveries != fault.recoveries)
+		failed = "restarted again";
+
+	printf("%-10s %6u %6u %6u %6u%s%s\n", test->name,
+			after.errors - before.errors, after.drifts - before.drifts,
+			after.overruns - before.overruns, after.recoveries - before.recoveries,
+			failed ? "  FAIL " : "", failed ? failed : "");
+
+	return failed != NULL;
+}
+
+int main(void)
+{
+	printf("%-10s %6s %6s %6s %6s\n", "Fault", "Errors", "Drifts", "Overs", "Resets");
+
+	return hostsim_runIsolated(recovery_case, RECOVERY_CASE_NUM);
+}
@@ -0,0 +1,198 @@
+/**
+ * ========================
+ * File: test_snr.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Checks the Q15 build of
+ * each effect against the float
+ * build. Built both ways, the
+ * float build renders the same
+ * input through each effect on
+ * its own and saves it, then
+ * the Q15 build renders it again
+ * and compares. Fails if an
+ * effect is under its minimum
+ * SNR, the table in the README.
+ * Each effect is rendered in a
+ * process of its own, so each
+ * starts from fresh state.
+ *
+ *   test_snr render FILE
+ *   test_snr_q15 compare FILE
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// 2s at 44.1khz of each effect, both channels
+#define SNR_FRAMES ((uint32_t)88200)
+#define SNR_SAMPLES (SNR_FRAMES*2)
+
+// minimum SNR of each Q15 kernel against float,
+// keep these the same as the table in the README
+static const double snr_minimum[EFFECT_NUM] =
+{
+	[EFFECT_DISTORTION] = 60.0,
+	[EFFECT_DELAY]      = 60.0,
+	[EFFECT_TREMOLO]    = 50.0,
+	[EFFECT_WAHWAH]     = 40.0,
+	[EFFECT_FLANGER]    = 30.0,
+	[EFFECT_VIBRATO]    = 30.0,
+};
+
+static int16_t render[SNR_SAMPLES];
+static uint32_t render_pos;
+static uint32_t source_pos;
+
+// what main was asked to do
+static int snr_compare;
+static const char* snr_path;
+
+/**
+ * @brief Guitar-ish input, a few sines
+ *        on the left channel.
+ *
+ * @param samples Where to put them
+ * @param count Number of samples
+ *
+ * @retval None
+ */
+static void snr_source(int16_t* samples, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i += 2)
+	{
+		float t = source_pos++;
+		samples[i] = (int16_t)(6000*sinf(t*0.05f) + 3000*sinf(t*0.013f) + 1500*sinf(t*0.21f));
+		samples[i+1] = 0;
+	}
+}
+
+/**
+ * @brief Keep what's played, both channels.
+ *
+ * @param samples Samples played
+ * @param count Number of samples
+ *
+ * @retval None
+ */
+static void snr_sink(const int16_t* samples, uint32_t count)
+{
+	for(uint32_t i = 0; i < count && render_pos < SNR_SAMPLES; i++)
+		render[render_pos++] = samples[i];
+}
+
+/**
+ * @brief Render the input through one
+ *        effect on its own.
+ *
+ * @param type The effect
+ *
+ * @retval None
+ */
+static void snr_render(EffectType type)
+{
+	arena_init();
+	registry_init();
+
+	for(int i = 0; i < EFFECT_NUM; i++)
+		registry_effects[i]->on = (i == type);
+
+	render_pos = 0;
+	source_pos = 0;
+
+	engine_init(registry_effects, EFFECT_NUM);
+	engine_start();
+	hostsim_audio_setSource(snr_source);
+	hostsim_audio_setSink(snr_sink);
+
+	while(render_pos < SNR_SAMPLES)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+}
+
+/**
+ * @brief Render one effect and save it, or
+ *        compare it with the saved render.
+ *        Run for each effect in a process of
+ *        its own by hostsim_runIsolated().
+ *
+ * @param type The effect
+ *
+ * @retval 0 if it passed, 1 if it failed,
+ *         2 if the file couldn't be used
+ */
+static int snr_effect(int type)
+{
+	static int16_t reference[SNR_SAMPLES];
+	long offset = (long)type * sizeof(render);
+	const char* path = snr_path;
+
+	snr_render((EffectType)type);
+
+	FILE* file = fopen(path, snr_compare ? "rb" : "r+b");
+	if(file == NULL || fseek(file, offset, SEEK_SET) != 0)
+	{
+		perror(path);
+		return 2;
+	}
+
+	if(!snr_compare)
+	{
+		int written = fwrite(render, sizeof(render), 1, file) == 1;
+		fclose(file);
+		return written ? 0 : 2;
+	}
+
+	int read = fread(reference, sizeof(reference), 1, file) == 1;
+	fclose(file);
+	if(!read)
+	{
+		fprintf(stderr, "%s: no render of effect %d\n", path, type);
+		return 2;
+	}
+
+	double snr = hostsim_snr(reference, render, SNR_SAMPLES);
+	int ok = snr >= snr_minimum[type];
+
+	printf("%-10s %5.1f dB %5.1f dB%s\n", registry_effects[type]->name,
+			snr_minimum[type], snr, ok ? "" : "  FAIL");
+
+	return !ok;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc != 3 || (strcmp(argv[1], "render") && strcmp(argv[1], "compare")))
+	{
+		fprintf(stderr, "usage: %s render|compare FILE\n", argv[0]);
+		return 2;
+	}
+
+	snr_compare = strcmp(argv[1], "compare") == 0;
+	snr_path = argv[2];
+
+	// start with an empty file to render into
+	if(!snr_compare)
+	{
+		FILE* file = fopen(snr_path, "wb");
+		if(file == NULL)
+		{
+			perror(snr_path);
+			return 2;
+		}
+		fclose(file);
+	}
+	else
+		printf("%-10s %8s %8s\n", "Effect", "Minimum", "SNR");
+
+	return hostsim_runIsolated(snr_effect, EFFECT_NUM);
+}
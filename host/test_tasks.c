@@ -0,0 +1,378 @@
+/**
+ * ========================
+ * File: test_tasks.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Stress tests the task
+ * scheduler on its pthread port.
+ *
+ * - a full queue drops what's
+ *   sent to it and counts it,
+ *   and the rest come out in
+ *   the order they went in
+ * - messages from threads
+ *   sending at once all arrive
+ *   or are counted as dropped
+ * - the audio task never runs
+ *   while task_lockAudio() is
+ *   held
+ * - task_stop() waits for the
+ *   threads and nothing runs
+ *   after it
+ *
+ * Each case runs in a process of
+ * its own, so each starts with
+ * no threads and empty queues.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "tasks.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define TEST_QUEUE_SIZE 8
+
+// threads sending to the UI queue at once
+#define TEST_PRODUCERS 3
+#define TEST_MESSAGES 20000
+
+// times round the lock while the audio task runs
+#define TEST_LOCKS 20000
+
+/**
+ * @brief A message, which thread sent it
+ *        and its number from that thread
+ */
+typedef struct
+{
+	uint32_t from;
+	uint32_t seq;
+}TestMessage;
+
+static TaskQueue test_queue;
+static TestMessage test_items[TEST_QUEUE_SIZE];
+
+// what the UI task took from each producer
+static volatile uint32_t test_received[TEST_PRODUCERS];
+static uint32_t test_last[TEST_PRODUCERS];
+static volatile uint32_t test_outOfOrder;
+
+static volatile int test_inAudio;
+static volatile uint32_t test_audioRuns;
+
+/**
+ * @brief Print a failed check.
+ *
+ * @param name The case
+ * @param what What went wrong
+ *
+ * @retval 1
+ */
+static int test_fail(const char* name, const char* what)
+{
+	printf("%-10s FAIL  %s\n", name, what);
+	return 1;
+}
+
+/**
+ * @brief Send more than a queue holds with
+ *        nothing taking from it.
+ *
+ * @param None
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int test_overflow(void)
+{
+	const uint32_t extra = 5;
+	uint32_t full = 0;
+	TestMessage message;
+
+	task_queueInit(&test_queue, test_items, sizeof(TestMessage), TEST_QUEUE_SIZE, TASK_UI);
+
+	for(uint32_t i = 0; i < TEST_QUEUE_SIZE + extra; i++)
+	{
+		message.from = 0;
+		message.seq = i;
+		if(task_send(&test_queue, &message) < 0)
+			full++;
+	}
+
+	if(full != extra || test_queue.dropped != extra)
+		return test_fail("overflow", "wrong number dropped");
+
+	// the first ones sent are the ones kept
+	for(uint32_t i = 0; i < TEST_QUEUE_SIZE; i++)
+		if(!task_receive(&test_queue, &message) || message.seq != i)
+			return test_fail("overflow", "messages out of order");
+
+	if(task_receive(&test_queue, &message))
+		return test_fail("overflow", "queue not empty");
+
+	printf("%-10s ok    %u dropped\n", "overflow", full);
+	return 0;
+}
+
+/**
+ * @brief Messages dropped by the queue, read
+ *        under the lock the queue uses.
+ *
+ * @param None
+ *
+ * @retval Number of messages
+ */
+static uint32_t test_dropped(void)
+{
+	uint32_t dropped;
+
+	__disable_irq();
+	dropped = test_queue.dropped;
+	__enable_irq();
+
+	return dropped;
+}
+
+/**
+ * @brief Messages waiting on the queue, read
+ *        under the lock the queue uses.
+ *
+ * @param None
+ *
+ * @retval Number of messages
+ */
+static uint32_t test_waiting(void)
+{
+	uint32_t count;
+
+	__disable_irq();
+	count = test_queue.count;
+	__enable_irq();
+
+	return count;
+}
+
+/**
+ * @brief UI task, takes everything on the
+ *        queue and checks the order.
+ *
+ * @param arg Not used
+ *
+ * @retval None
+ */
+static void test_ui(void* arg)
+{
+	TestMessage message;
+
+	// the UI thread can outrank the senders, hold
+	// off until they've filled the queue once so
+	// the dropping is tested every time
+	while(!test_dropped())
+		usleep(100);
+
+	while(task_receive(&test_queue, &message))
+	{
+		// each thread's messages keep their order,
+		// there can be gaps where some were dropped
+		if(message.seq <= test_last[message.from])
+			test_outOfOrder++;
+		test_last[message.from] = message.seq;
+		test_received[message.from]++;
+	}
+}
+
+/**
+ * @brief Thread sending numbered messages.
+ *
+ * @param arg Number of the thread
+ *
+ * @retval Number of messages that got on
+ */
+static void* test_producer(void* arg)
+{
+	uint32_t from = (uint32_t)(uintptr_t)arg;
+	uintptr_t sent = 0;
+
+	for(uint32_t i = 1; i <= TEST_MESSAGES; i++)
+	{
+		TestMessage message = {from, i};
+		if(task_send(&test_queue, &message) == 0)
+			sent++;
+	}
+
+	return (void*)sent;
+}
+
+/**
+ * @brief Threads all sending to the UI
+ *        task at once.
+ *
+ * @param None
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int test_producers(void)
+{
+	pthread_t threads[TEST_PRODUCERS];
+	uint32_t sent[TEST_PRODUCERS];
+	uint32_t sentTotal = 0;
+	uint32_t receivedTotal = 0;
+
+	task_queueInit(&test_queue, test_items, sizeof(TestMessage), TEST_QUEUE_SIZE, TASK_UI);
+	task_set(TASK_UI, test_ui, NULL);
+	task_start();
+
+	for(int i = 0; i < TEST_PRODUCERS; i++)
+		pthread_create(&threads[i], NULL, test_producer, (void*)(uintptr_t)i);
+
+	for(int i = 0; i < TEST_PRODUCERS; i++)
+	{
+		void* result;
+		pthread_join(threads[i], &result);
+		sent[i] = (uint32_t)(uintptr_t)result;
+		sentTotal += sent[i];
+	}
+
+	// give the UI task up to a second to catch up,
+	// task_stop() lets the run it's on finish
+	for(int wait = 0; wait < 1000 && test_waiting(); wait++)
+		usleep(1000);
+
+	task_stop();
+
+	for(int i = 0; i < TEST_PRODUCERS; i++)
+	{
+		if(test_received[i] != sent[i])
+			return test_fail("producers", "sent and received differ");
+		receivedTotal += test_received[i];
+	}
+
+	if(sentTotal + test_queue.dropped != TEST_PRODUCERS*TEST_MESSAGES)
+		return test_fail("producers", "messages lost without being dropped");
+	if(test_queue.dropped == 0)
+		return test_fail("producers", "queue never filled");
+	if(test_outOfOrder)
+		return test_fail("producers", "messages out of order");
+
+	printf("%-10s ok    %u received %u dropped\n", "producers", receivedTotal, test_queue.dropped);
+	return 0;
+}
+
+/**
+ * @brief Audio task, marks that it's
+ *        running and spins a while.
+ *
+ * @param arg Not used
+ *
+ * @retval None
+ */
+static void test_audio(void* arg)
+{
+	test_inAudio = 1;
+	test_audioRuns++;
+	for(volatile int i = 0; i < 1000; i++)
+		;
+	test_inAudio = 0;
+}
+
+/**
+ * @brief Take the audio lock over and over
+ *        while the audio task is signalled.
+ *
+ * @param None
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int test_lock(void)
+{
+	uint32_t clashes = 0;
+
+	task_set(TASK_AUDIO, test_audio, NULL);
+	task_start();
+
+	for(int i = 0; i < TEST_LOCKS; i++)
+	{
+		task_signal(TASK_AUDIO);
+
+		task_lockAudio();
+		for(volatile int j = 0; j < 200; j++)
+			if(test_inAudio)
+				clashes++;
+		task_unlockAudio();
+	}
+
+	task_stop();
+
+	if(clashes)
+		return test_fail("lock", "audio task ran while locked");
+	if(test_audioRuns == 0)
+		return test_fail("lock", "audio task never ran");
+
+	printf("%-10s ok    %u audio runs\n", "lock", test_audioRuns);
+	return 0;
+}
+
+/**
+ * @brief Stop the tasks while the audio
+ *        task is busy, then signal it.
+ *
+ * @param None
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int test_stop(void)
+{
+	task_set(TASK_AUDIO, test_audio, NULL);
+	task_start();
+
+	for(int i = 0; i < 1000; i++)
+		task_signal(TASK_AUDIO);
+
+	task_stop();
+
+	// the thread is joined, so a run can't be half done
+	uint32_t runs = test_audioRuns;
+	if(test_inAudio)
+		return test_fail("stop", "audio task still running");
+
+	for(int i = 0; i < 100; i++)
+		task_signal(TASK_AUDIO);
+	usleep(10000);
+
+	if(test_audioRuns != runs)
+		return test_fail("stop", "audio task ran after stop");
+
+	printf("%-10s ok    %u audio runs\n", "stop", runs);
+	return 0;
+}
+
+static int (*const test_cases[])(void) =
+{
+	test_overflow,
+	test_producers,
+	test_lock,
+	test_stop,
+};
+
+#define TEST_CASE_NUM ((int)(sizeof(test_cases)/sizeof(test_cases[0])))
+
+/**
+ * @brief Run one case, in a process of its
+ *        own from hostsim_runIsolated().
+ *
+ * @param index The case
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int test_case(int index)
+{
+	return test_cases[index]();
+}
+
+int main(void)
+{
+	return hostsim_runIsolated(test_case, TEST_CASE_NUM);
+}
@@ -0,0 +1,77 @@
+/**
+ * ========================
+ * File: test_trace.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Streams blocks with the
+ * trace ring on, changing the
+ * volume, the effects that are
+ * on and the block size along
+ * the way, then dumps the ring
+ * to stdout. The test target
+ * runs the dump through
+ * tools/trace_json.py and
+ * check_trace.py checks the JSON.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+
+// half transfers between each change, the
+// ring holds about the last 250 blocks
+#define TRACE_STEPS 100
+
+/**
+ * @brief Step the DMA and let the engine
+ *        take each block as it comes.
+ *
+ * @param steps Number of half transfers
+ *
+ * @retval None
+ */
+static void trace_stream(uint32_t steps)
+{
+	for(uint32_t i = 0; i < steps; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+}
+
+int main(void)
+{
+	arena_init();
+	trace_init();
+	registry_init();
+
+	engine_init(registry_effects, EFFECT_NUM);
+	engine_start();
+	trace_stream(TRACE_STEPS);
+
+	// codec writes show up as spans on
+	// the audio track
+	engine_setVolume(50);
+	trace_stream(TRACE_STEPS);
+
+	for(int i = 0; i < EFFECT_NUM; i++)
+		if(registry_effects[i])
+			registry_effects[i]->on = 1;
+	engine_updateChain();
+	trace_stream(TRACE_STEPS);
+
+	// restarts the streams between blocks
+	engine_setBlockFrames(AUDIO_BLOCK_FRAMES_MIN);
+	trace_stream(TRACE_STEPS);
+
+	engine_setVolume(70);
+	trace_stream(TRACE_STEPS);
+
+	trace_dump();
+	return 0;
+}
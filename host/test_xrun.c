@@ -0,0 +1,165 @@
+/**
+ * ========================
+ * File: test_xrun.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Checks the engine counts
+ * xruns and restarts the streams
+ * on a run of them.
+ *
+ * - two half transfers before
+ *   the engine runs leave the
+ *   first block late, an underrun
+ * - a third writes over it, an
+ *   overrun
+ * - the DMA moving on while a
+ *   block is processed makes it
+ *   late too
+ * - one block short of
+ *   ENGINE_XRUN_RESTART late
+ *   blocks in a row is only
+ *   counted
+ * - ENGINE_XRUN_RESTART in a row
+ *   restarts the streams
+ *
+ * Linked with --wrap on
+ * SCB_InvalidateDCache_by_Addr,
+ * which the engine calls at the
+ * start of each block, so the
+ * DMA can be stepped from inside
+ * a block. Each case runs in a
+ * process of its own, so each
+ * starts from fresh arenas.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "arena.h"
+#include "engine.h"
+#include "registry.h"
+#include <stdio.h>
+
+// half transfers to stream before and after
+#define XRUN_STEPS 200
+
+/**
+ * @brief An xrun to make and how much each
+ *        counter should go up by
+ */
+typedef struct
+{
+	const char* name;
+	uint32_t steps; // DMA steps before the engine runs
+	uint32_t late;  // blocks the DMA moves on during
+	uint32_t overruns;
+	uint32_t underruns;
+	uint32_t recoveries;
+}XrunCase;
+
+static const XrunCase xrun_cases[] =
+{
+	// the older of the two blocks waiting is late
+	{"two steps", 2, 0, 0, 1, 0},
+	// and the newer one has been written over
+	{"overrun", 3, 0, 1, 1, 0},
+	{"late",    1, 1, 0, 1, 0},
+	{"short",   1, ENGINE_XRUN_RESTART - 1, 0, ENGINE_XRUN_RESTART - 1, 0},
+	{"restart", 1, ENGINE_XRUN_RESTART,     0, ENGINE_XRUN_RESTART,     1},
+};
+
+#define XRUN_CASE_NUM ((int)(sizeof(xrun_cases)/sizeof(xrun_cases[0])))
+
+// blocks still to make late
+static uint32_t xrun_late;
+
+void __real_SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t dsize);
+
+void __wrap_SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t dsize)
+{
+	__real_SCB_InvalidateDCache_by_Addr(addr, dsize);
+
+	// the next half transfer lands while
+	// this block is being processed
+	if(xrun_late)
+	{
+		xrun_late--;
+		hostsim_dma_step();
+	}
+}
+
+/**
+ * @brief Step the DMA and let the engine
+ *        take each block as it comes.
+ *
+ * @param steps Number of half transfers
+ *
+ * @retval None
+ */
+static void xrun_stream(uint32_t steps)
+{
+	for(uint32_t i = 0; i < steps; i++)
+	{
+		hostsim_dma_step();
+		engine_service();
+	}
+}
+
+/**
+ * @brief Make one kind of xrun and check
+ *        the counters and the restart.
+ *
+ * @param index The case
+ *
+ * @retval 0 if it passed, 1 if not
+ */
+static int xrun_case(int index)
+{
+	const XrunCase* test = &xrun_cases[index];
+	EngineStats before, after;
+
+	arena_init();
+	registry_init();
+
+	engine_init(registry_effects, EFFECT_NUM);
+	engine_start();
+	xrun_stream(XRUN_STEPS);
+	engine_getStats(&before);
+
+	xrun_late = test->late;
+	for(uint32_t i = 0; i < test->steps; i++)
+		hostsim_dma_step();
+	engine_service();
+
+	xrun_stream(XRUN_STEPS);
+	engine_getStats(&after);
+
+	uint32_t overruns = after.overruns - before.overruns;
+	uint32_t underruns = after.underruns - before.underruns;
+	uint32_t recoveries = after.recoveries - before.recoveries;
+
+	const char* failed = NULL;
+	if(overruns != test->overruns)
+		failed = "wrong number of overruns";
+	else if(underruns != test->underruns)
+		failed = "wrong number of underruns";
+	else if(recoveries != test->recoveries)
+		failed = "wrong number of restarts";
+	// blocks keep coming once the xruns stop
+	else if(after.blocks - before.blocks < XRUN_STEPS)
+		failed = "blocks stopped";
+
+	printf("%-10s %6u %6u %6u %6u%s%s\n", test->name, overruns, underruns,
+			recoveries, after.blocks - before.blocks,
+			failed ? "  FAIL " : "", failed ? failed : "");
+
+	return failed != NULL;
+}
+
+int main(void)
+{
+	printf("%-10s %6s %6s %6s %6s\n", "Xrun", "Overs", "Unders", "Resets", "Blocks");
+
+	return hostsim_runIsolated(xrun_case, XRUN_CASE_NUM);
+}
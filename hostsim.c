@@ -0,0 +1,451 @@
+/**
+ * ========================
+ * File: hostsim.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Host side stand in
+ * for the board. Build with
+ * HOST_SIM defined and main.h
+ * pulls this in instead of
+ * the HAL/BSP. Gives us a
+ * simulated audio DMA so the
+ * engine can be run on Linux.
+ *
+ * The DMA buffers are modelled
+ * as a cache that never lets go.
+ * The DMA works on memory of its
+ * own, the CPU only sees it after
+ * an invalidate and the DMA only
+ * sees what the CPU wrote after a
+ * clean.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifdef HOST_SIM
+
+#include "main.h"
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pthread.h>
+
+// same as the board, 25MHz / 25 * 400 / 2 in SystemClock_Init()
+uint32_t SystemCoreClock = 200000000;
+
+// where the DMA streams are pointed
+static int16_t* rec_buffer;
+static uint32_t rec_size;   // half-words
+static int16_t* play_buffer;
+static uint32_t play_size;  // half-words
+
+// what the DMA sees, the buffers the engine
+// gave us are what the CPU sees through the
+// cache. a record half the DMA has written that
+// the CPU hasn't invalidated yet is fresh.
+static int16_t* rec_memory;
+static int16_t* play_memory;
+static uint8_t rec_fresh[2];
+static uint32_t cache_stale;
+
+// held while interrupts are masked and while the
+// DMA step runs, so it's recursive
+static pthread_mutex_t irq_lock;
+static pthread_once_t irq_once = PTHREAD_ONCE_INIT;
+
+static HostSimSource audio_source;
+static HostSimSink audio_sink;
+
+// which half the DMA is on, playback
+// is on the other half unless it's drifted
+static uint32_t dma_events;
+static int dma_half;
+static int play_slip;
+static int play_now;
+
+// fault to make and how many more times
+static HostSimFault fault;
+static uint32_t fault_count;
+
+uint8_t BSP_AUDIO_IN_OUT_Init(uint16_t InputDevice, uint16_t OutputDevice, uint32_t AudioFreq, uint32_t BitRes, uint32_t ChnlNbr)
+{
+	rec_buffer = NULL;
+	play_buffer = NULL;
+	dma_events = 0;
+	dma_half = 0;
+	play_slip = 0;
+	play_now = 1;
+	return AUDIO_OK;
+}
+
+uint8_t BSP_AUDIO_IN_Record(uint16_t* pData, uint32_t Size)
+{
+	// size is in half-words
+	rec_buffer = (int16_t*)pData;
+	rec_size = Size;
+
+	// memory starts the same as the cache
+	rec_memory = realloc(rec_memory, rec_size*2);
+	memcpy(rec_memory, rec_buffer, rec_size*2);
+	rec_fresh[0] = 0;
+	rec_fresh[1] = 0;
+	return AUDIO_OK;
+}
+
+uint8_t BSP_AUDIO_OUT_Play(uint16_t* pBuffer, uint32_t Size)
+{
+	// size is in bytes
+	play_buffer = (int16_t*)pBuffer;
+	play_size = Size/2;
+
+	play_memory = realloc(play_memory, play_size*2);
+	memcpy(play_memory, play_buffer, play_size*2);
+	return AUDIO_OK;
+}
+
+uint8_t BSP_AUDIO_IN_Stop(uint32_t Option)
+{
+	rec_buffer = NULL;
+	return AUDIO_OK;
+}
+
+uint8_t BSP_AUDIO_OUT_Stop(uint32_t Option)
+{
+	play_buffer = NULL;
+	return AUDIO_OK;
+}
+
+uint8_t BSP_AUDIO_OUT_SetMute(uint32_t Cmd)
+{
+	return AUDIO_OK;
+}
+
+uint8_t BSP_AUDIO_OUT_SetVolume(uint8_t Volume)
+{
+	return AUDIO_OK;
+}
+
+void BSP_AUDIO_OUT_SetAudioFrameSlot(uint32_t AudioFrameSlot)
+{
+	return;
+}
+
+void hostsim_audio_setSource(HostSimSource source)
+{
+	audio_source = source;
+}
+
+void hostsim_audio_setSink(HostSimSink sink)
+{
+	audio_sink = sink;
+}
+
+/**
+ * @brief Move the simulated DMA on by one
+ *        half transfer. Records the next
+ *        input half, starts playing the next
+ *        output half and fires the callback.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void hostsim_dma_step(void)
+{
+	hostsim_irq_lock();
+
+	if(rec_buffer == NULL || play_buffer == NULL)
+	{
+		hostsim_irq_unlock();
+		return;
+	}
+
+	int16_t* rec_half = rec_memory + (dma_half * rec_size/2);
+
+	// playback moves onto the other half, whatever
+	// is in there now is what gets played
+	int play = (1 - dma_half + play_slip) & 1;
+	int16_t* play_half = play_memory + (play * play_size/2);
+	play_now = play;
+
+	// the CPU never picked up the last
+	// recording in this half
+	if(rec_fresh[dma_half])
+		cache_stale++;
+	rec_fresh[dma_half] = 1;
+
+	if(audio_source)
+		audio_source(rec_half, rec_size/2);
+	else
+		memset(rec_half, 0, rec_size);
+
+	// the CPU wrote this half and didn't clean it
+	if(memcmp(play_half, play_buffer + (play * play_size/2), play_size))
+		cache_stale++;
+
+	if(audio_sink)
+		audio_sink(play_half, play_size/2);
+
+	dma_events++;
+
+	HostSimFault now = HOSTSIM_FAULT_NONE;
+	if(fault_count)
+	{
+		now = fault;
+		fault_count--;
+	}
+
+	if(now == HOSTSIM_FAULT_IN_ERROR)
+		BSP_AUDIO_IN_Error_CallBack();
+	else if(now == HOSTSIM_FAULT_OUT_ERROR)
+		BSP_AUDIO_OUT_Error_CallBack();
+	else if(now == HOSTSIM_FAULT_DRIFT)
+		play_slip = 1;
+
+	if(now == HOSTSIM_FAULT_DROP_IRQ)
+		; // the half moves on but nobody is told
+	else if(dma_half == 0)
+		BSP_AUDIO_IN_HalfTransfer_CallBack();
+	else
+		BSP_AUDIO_IN_TransferComplete_CallBack();
+
+	dma_half = 1 - dma_half;
+
+	hostsim_irq_unlock();
+}
+
+/**
+ * @brief Make a fault on the next DMA steps.
+ *        Drift is a one off, the others
+ *        happen on each of the next count
+ *        steps.
+ *
+ * @param newFault Fault to make
+ * @param count Number of steps to make it on
+ *
+ * @retval None
+ */
+void hostsim_fault_inject(HostSimFault newFault, uint32_t count)
+{
+	fault = newFault;
+	fault_count = (newFault == HOSTSIM_FAULT_DRIFT) ? 1 : count;
+}
+
+/**
+ * @brief Copy the part of a DMA buffer a cache
+ *        operation covers, between what the CPU
+ *        sees and what the DMA sees.
+ *
+ * @param cpu Buffer the CPU sees
+ * @param memory Buffer the DMA sees
+ * @param bytes Size of both
+ * @param addr Start of the operation
+ * @param dsize Size of the operation
+ * @param clean 1 copies CPU to memory, 0 memory to CPU
+ *
+ * @retval Which halves it covered all of, as bits
+ */
+static int hostsim_cacheCopy(int16_t* cpu, int16_t* memory, uint32_t bytes, uint8_t* addr, int32_t dsize, int clean)
+{
+	uint8_t* base = (uint8_t*)cpu;
+	int halves = 0;
+
+	if(cpu == NULL || addr + dsize <= base || addr >= base + bytes)
+		return 0;
+
+	uint32_t start = (addr > base) ? addr - base : 0;
+	uint32_t end = (addr + dsize < base + bytes) ? addr + dsize - base : bytes;
+
+	if(clean)
+		memcpy((uint8_t*)memory + start, base + start, end - start);
+	else
+		memcpy(base + start, (uint8_t*)memory + start, end - start);
+
+	for(int half = 0; half < 2; half++)
+		if(start <= half*bytes/2 && end >= (half+1)*bytes/2)
+			halves |= 1 << half;
+
+	return halves;
+}
+
+void SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t dsize)
+{
+	// on the board this throws away the rest of the line
+	if(((uintptr_t)addr | dsize) & 31)
+		cache_stale++;
+
+	int halves = hostsim_cacheCopy(rec_buffer, rec_memory, rec_size*2, (uint8_t*)addr, dsize, 0);
+	hostsim_cacheCopy(play_buffer, play_memory, play_size*2, (uint8_t*)addr, dsize, 0);
+
+	for(int half = 0; half < 2; half++)
+		if(halves & (1 << half))
+			rec_fresh[half] = 0;
+}
+
+void SCB_CleanDCache_by_Addr(uint32_t* addr, int32_t dsize)
+{
+	if(((uintptr_t)addr | dsize) & 31)
+		cache_stale++;
+
+	hostsim_cacheCopy(rec_buffer, rec_memory, rec_size*2, (uint8_t*)addr, dsize, 1);
+	hostsim_cacheCopy(play_buffer, play_memory, play_size*2, (uint8_t*)addr, dsize, 1);
+}
+
+uint32_t hostsim_cache_stale(void)
+{
+	return cache_stale;
+}
+
+uint32_t hostsim_play_half(void)
+{
+	return play_now;
+}
+
+uint32_t hostsim_dma_events(void)
+{
+	return dma_events;
+}
+
+/**
+ * @brief Make the recursive interrupt lock,
+ *        the first time it's used.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+static void hostsim_irq_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&irq_lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+void hostsim_irq_lock(void)
+{
+	pthread_once(&irq_once, hostsim_irq_init);
+	pthread_mutex_lock(&irq_lock);
+}
+
+void hostsim_irq_unlock(void)
+{
+	pthread_mutex_unlock(&irq_lock);
+}
+
+void hostsim_wfi(void)
+{
+	hostsim_dma_step();
+}
+
+/**
+ * @brief Stand in for the board's Error_Handler(),
+ *        ends the run so a test sees it failed.
+ *
+ * @param None
+ *
+ * @retval None, never returns
+ */
+void Error_Handler(void)
+{
+	fflush(stdout);
+	fprintf(stderr, "Error_Handler called\n");
+	exit(1);
+}
+
+/**
+ * @brief Stand in for the DWT cycle counter,
+ *        host time counted in cycles of
+ *        SystemCoreClock.
+ *
+ * @param None
+ *
+ * @retval Cycles, wraps
+ */
+uint32_t hostsim_cycles(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	// seconds and nanoseconds separately, ns * SystemCoreClock
+	// would overflow 64 bits after about 85s of uptime
+	uint64_t cycles = (uint64_t)now.tv_sec * SystemCoreClock
+			+ (uint64_t)now.tv_nsec * SystemCoreClock / 1000000000u;
+	return (uint32_t)cycles;
+}
+
+/**
+ * @brief Signal to noise ratio of a render
+ *        against a reference render, used to
+ *        check the Q15 build against float.
+ *
+ * @param reference Samples from the reference build
+ * @param test Samples from the build under test
+ * @param count Number of samples
+ *
+ * @retval SNR in dB, 200 if they match exactly
+ */
+double hostsim_snr(const int16_t* reference, const int16_t* test, uint32_t count)
+{
+	double signal = 0;
+	double noise = 0;
+
+	for(uint32_t i = 0; i < count; i++)
+	{
+		double error = (double)test[i] - reference[i];
+		signal += (double)reference[i] * reference[i];
+		noise += error * error;
+	}
+
+	if(noise == 0)
+		return 200.0;
+
+	return 10.0 * log10(signal / noise);
+}
+
+/**
+ * @brief Run each case of a test in a process
+ *        of its own, so each one starts from
+ *        fresh statics and none can be broken
+ *        by what the one before left behind.
+ *
+ * @param fn The case to run, given its number,
+ *        returns 0 if it passed
+ * @param n Number of cases
+ *
+ * @retval 0 if they all passed, else the worst
+ *         result, 2 if a case crashed
+ */
+int hostsim_runIsolated(int (*fn)(int), int n)
+{
+	int worst = 0;
+
+	for(int i = 0; i < n; i++)
+	{
+		int status;
+
+		// so the child doesn't print what's buffered again
+		fflush(stdout);
+
+		pid_t child = fork();
+		if(child == 0)
+			exit(fn(i));
+
+		if(child < 0 || waitpid(child, &status, 0) < 0 || !WIFEXITED(status))
+			return 2;
+
+		if(WEXITSTATUS(status) > worst)
+			worst = WEXITSTATUS(status);
+	}
+
+	return worst;
+}
+
+#endif
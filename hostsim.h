@@ -0,0 +1,235 @@
+/**
+ * ========================
+ * File: hostsim.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Host side stand in
+ * for the board. Build with
+ * HOST_SIM defined and main.h
+ * pulls this in instead of
+ * the HAL/BSP. Gives us a
+ * simulated audio DMA so the
+ * engine can be run on Linux.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __HOSTSIM_H
+#define __HOSTSIM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+// audio BSP values we use
+#define AUDIO_OK                        ((uint8_t)0)
+#define AUDIO_ERROR                     ((uint8_t)1)
+#define AUDIO_MUTE_OFF                  ((uint32_t)0)
+#define AUDIO_MUTE_ON                   ((uint32_t)1)
+#define INPUT_DEVICE_INPUT_LINE_1       ((uint16_t)0x0300)
+#define OUTPUT_DEVICE_HEADPHONE         ((uint16_t)0x0002)
+#define I2S_AUDIOFREQ_96K               ((uint32_t)96000U)
+#define I2S_AUDIOFREQ_48K               ((uint32_t)48000U)
+#define I2S_AUDIOFREQ_44K               ((uint32_t)44100U)
+#define DEFAULT_AUDIO_IN_BIT_RESOLUTION ((uint8_t)16)
+#define DEFAULT_AUDIO_IN_CHANNEL_NBR    ((uint8_t)2)
+#define CODEC_AUDIOFRAME_SLOT_02        ((uint32_t)0x0005)
+#define CODEC_PDWN_SW                   ((uint32_t)0x0002)
+
+// the simulated DMA is the only interrupt. it runs
+// when the engine goes to sleep, or from whatever
+// thread steps it when the tasks are threads.
+// masking interrupts holds it off either way.
+#define __disable_irq() hostsim_irq_lock()
+#define __enable_irq()  hostsim_irq_unlock()
+#define __WFI()         hostsim_wfi()
+#define __DMB()         __sync_synchronize()
+
+// core clock the host pretends to run at
+extern uint32_t SystemCoreClock;
+
+// audio BSP
+uint8_t BSP_AUDIO_IN_OUT_Init(uint16_t InputDevice, uint16_t OutputDevice, uint32_t AudioFreq, uint32_t BitRes, uint32_t ChnlNbr);
+uint8_t BSP_AUDIO_IN_Record(uint16_t* pData, uint32_t Size);
+uint8_t BSP_AUDIO_OUT_Play(uint16_t* pBuffer, uint32_t Size);
+uint8_t BSP_AUDIO_IN_Stop(uint32_t Option);
+uint8_t BSP_AUDIO_OUT_Stop(uint32_t Option);
+uint8_t BSP_AUDIO_OUT_SetMute(uint32_t Cmd);
+uint8_t BSP_AUDIO_OUT_SetVolume(uint8_t Volume);
+void    BSP_AUDIO_OUT_SetAudioFrameSlot(uint32_t AudioFrameSlot);
+void    BSP_AUDIO_IN_TransferComplete_CallBack(void);
+void    BSP_AUDIO_IN_HalfTransfer_CallBack(void);
+void    BSP_AUDIO_IN_Error_CallBack(void);
+void    BSP_AUDIO_OUT_Error_CallBack(void);
+
+// D-cache maintenance, see hostsim.c for the model
+void SCB_InvalidateDCache_by_Addr(uint32_t* addr, int32_t dsize);
+void SCB_CleanDCache_by_Addr(uint32_t* addr, int32_t dsize);
+
+/**
+ * @brief Faults the simulated DMA can be
+ *        told to make, for testing recovery
+ */
+typedef enum
+{
+	HOSTSIM_FAULT_NONE = 0,
+	HOSTSIM_FAULT_IN_ERROR,  // record SAI reports an error
+	HOSTSIM_FAULT_OUT_ERROR, // playback SAI reports an error
+	HOSTSIM_FAULT_DROP_IRQ,  // DMA moves on without its callback
+	HOSTSIM_FAULT_DRIFT,     // playback slips a half behind record
+}HostSimFault;
+
+/**
+ * @brief Fills count samples of the record
+ *        buffer, called as the DMA "records".
+ */
+typedef void (*HostSimSource)(int16_t* samples, uint32_t count);
+
+/**
+ * @brief Gets count samples of the playback
+ *        buffer as the DMA starts "playing" them.
+ */
+typedef void (*HostSimSink)(const int16_t* samples, uint32_t count);
+
+/**
+ * @brief Set where recorded audio comes from.
+ *        Silence is recorded if NULL.
+ *
+ * @param source Source callback
+ *
+ * @retval None
+ */
+void hostsim_audio_setSource(HostSimSource source);
+
+/**
+ * @brief Set where played audio goes.
+ *        Played audio is dropped if NULL.
+ *
+ * @param sink Sink callback
+ *
+ * @retval None
+ */
+void hostsim_audio_setSink(HostSimSink sink);
+
+/**
+ * @brief Move the simulated DMA on by one
+ *        half transfer. Records the next
+ *        input half, starts playing the next
+ *        output half and fires the callback.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void hostsim_dma_step(void);
+
+/**
+ * @brief Make a fault on the next DMA steps.
+ *        Drift is a one off, the others
+ *        happen on each of the next count
+ *        steps.
+ *
+ * @param fault Fault to make
+ * @param count Number of steps to make it on
+ *
+ * @retval None
+ */
+void hostsim_fault_inject(HostSimFault fault, uint32_t count);
+
+/**
+ * @brief Which half playback is on, stands
+ *        in for reading the DMA counter.
+ *
+ * @param None
+ *
+ * @retval 0 for the first half, 1 for the second
+ */
+uint32_t hostsim_play_half(void);
+
+/**
+ * @brief Number of half transfers so far.
+ *
+ * @param None
+ *
+ * @retval Half transfer count
+ */
+uint32_t hostsim_dma_events(void);
+
+/**
+ * @brief Number of times stale data crossed
+ *        between the CPU and the DMA. A record
+ *        half the DMA wrote again before it was
+ *        invalidated, a playback half that went
+ *        out without being cleaned, or cache
+ *        maintenance on part of a line. A
+ *        missed block counts too.
+ *
+ * @param None
+ *
+ * @retval Stale count
+ */
+uint32_t hostsim_cache_stale(void);
+
+/**
+ * @brief Mask and unmask the simulated DMA
+ *        interrupt, stand in for PRIMASK. Can
+ *        be nested on one thread.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void hostsim_irq_lock(void);
+void hostsim_irq_unlock(void);
+
+/**
+ * @brief Stand in for WFI, the next
+ *        interrupt is the next DMA event.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void hostsim_wfi(void);
+
+/**
+ * @brief Stand in for the DWT cycle counter,
+ *        host time counted in cycles of
+ *        SystemCoreClock.
+ *
+ * @param None
+ *
+ * @retval Cycles, wraps
+ */
+uint32_t hostsim_cycles(void);
+
+/**
+ * @brief Signal to noise ratio of a render
+ *        against a reference render, used to
+ *        check the Q15 build against float.
+ *
+ * @param reference Samples from the reference build
+ * @param test Samples from the build under test
+ * @param count Number of samples
+ *
+ * @retval SNR in dB, 200 if they match exactly
+ */
+double hostsim_snr(const int16_t* reference, const int16_t* test, uint32_t count);
+
+/**
+ * @brief Run each case of a test in a process
+ *        of its own, so each one starts from
+ *        fresh statics.
+ *
+ * @param fn The case to run, given its number,
+ *        returns 0 if it passed
+ * @param n Number of cases
+ *
+ * @retval 0 if they all passed, else the worst
+ *         result, 2 if a case crashed
+ */
+int hostsim_runIsolated(int (*fn)(int), int n);
+
+#endif
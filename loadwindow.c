@@ -0,0 +1,206 @@
+/**
+ * ========================
+ * File: loadwindow.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: CPU load window, shows
+ * how much of the block budget
+ * each effect and the whole
+ * block take, from the engine
+ * profile. It's redrawn on each
+ * UI tick while it's up.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "loadwindow.h"
+#include "engine.h"
+#include "registry.h"
+
+// Use macros to define UI
+// widget locations.
+#define BACKBTN_X 0
+#define BACKBTN_Y 0
+#define BACKBTN_W 120
+#define BACKBTN_H 50
+#define RESETBTN_X 480-100
+#define RESETBTN_Y BACKBTN_Y
+#define RESETBTN_W 100
+#define RESETBTN_H BACKBTN_H
+#define TRACEBTN_X RESETBTN_X-105
+#define TRACEBTN_Y BACKBTN_Y
+#define TRACEBTN_W RESETBTN_W
+#define TRACEBTN_H BACKBTN_H
+#define TITLE_X BACKBTN_X+BACKBTN_W+10
+#define TITLE_Y BACKBTN_Y+(BACKBTN_H/4)
+#define HEADER_Y 56
+#define ROW_Y 72
+#define ROW_H 28
+#define NAME_X 5
+#define AVG_X 115
+#define MAX_X 185
+#define LOAD_X 255
+#define HIST_X 310
+#define HIST_W 20
+#define HIST_H 20
+
+// a row goes red when its max
+// is over this much of the budget
+#define LOAD_WARN 80
+
+static char row_text[30];
+
+/**
+ * @brief Draw one row, an effect or the block.
+ *
+ * @param row Row number, from the top
+ * @param name Name to show
+ * @param stats Its profile
+ *
+ * @retval None
+ */
+static void draw_row(int row, const char* name, const ProfileStats* stats)
+{
+	int y = ROW_Y + row*ROW_H;
+	uint32_t budget = profile_getBudget();
+	uint32_t maxLoad = (uint32_t)(stats->max * 100ull / budget);
+
+	// clear the row
+	BSP_LCD_SetTextColor(LCD_COLOR_DARKMAGENTA);
+	BSP_LCD_FillRect(0, y, 480, ROW_H);
+
+	BSP_LCD_SetFont(&Font16);
+	BSP_LCD_SetBackColor(LCD_COLOR_DARKMAGENTA);
+	BSP_LCD_SetTextColor(maxLoad > LOAD_WARN ? LCD_COLOR_RED : LCD_COLOR_WHITE);
+
+	sprintf(row_text, "%.9s", name);
+	BSP_LCD_DisplayStringAt(NAME_X, y+4, (uint8_t *)row_text, LEFT_MODE);
+
+	if(stats->count == 0)
+	{
+		BSP_LCD_DisplayStringAt(AVG_X, y+4, (uint8_t *)"off", LEFT_MODE);
+		return;
+	}
+
+	sprintf(row_text, "%4lu", (unsigned long)profile_toMicros(profile_average(stats)));
+	BSP_LCD_DisplayStringAt(AVG_X, y+4, (uint8_t *)row_text, LEFT_MODE);
+	sprintf(row_text, "%4lu", (unsigned long)profile_toMicros(stats->max));
+	BSP_LCD_DisplayStringAt(MAX_X, y+4, (uint8_t *)row_text, LEFT_MODE);
+	sprintf(row_text, "%3lu%%", (unsigned long)maxLoad);
+	BSP_LCD_DisplayStringAt(LOAD_X, y+4, (uint8_t *)row_text, LEFT_MODE);
+
+	// histogram, a bar for each eighth of the
+	// budget as tall as its share of the blocks
+	for(int i = 0; i < PROFILE_BUCKETS; i++)
+	{
+		uint32_t h = (uint32_t)((uint64_t)stats->buckets[i] * HIST_H / stats->count);
+		if(stats->buckets[i] && h == 0)
+			h = 1;
+
+		BSP_LCD_SetTextColor(i >= PROFILE_BUCKETS-2 ? LCD_COLOR_RED : LCD_COLOR_GREEN);
+		if(h)
+			BSP_LCD_FillRect(HIST_X + i*HIST_W, y+2+HIST_H-h, HIST_W-2, h);
+	}
+}
+
+/**
+ * @brief Draw the load window
+ *        onto the GLCD.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void loadwindow_draw(void)
+{
+	// first we clear the screen
+	BSP_LCD_Clear(LCD_COLOR_DARKMAGENTA);
+
+	// back and reset buttons
+	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+	BSP_LCD_FillRect(BACKBTN_X, BACKBTN_Y, BACKBTN_W, BACKBTN_H);
+	BSP_LCD_FillRect(RESETBTN_X, RESETBTN_Y, RESETBTN_W, RESETBTN_H);
+	BSP_LCD_FillRect(TRACEBTN_X, TRACEBTN_Y, TRACEBTN_W, TRACEBTN_H);
+	BSP_LCD_SetBackColor(LCD_COLOR_WHITE);
+	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
+	BSP_LCD_SetFont(&Font16);
+	BSP_LCD_DisplayStringAt(BACKBTN_X+3, BACKBTN_Y+3, (uint8_t *)"Back", LEFT_MODE);
+	BSP_LCD_DisplayStringAt(RESETBTN_X+3, RESETBTN_Y+3, (uint8_t *)"Reset", LEFT_MODE);
+	BSP_LCD_DisplayStringAt(TRACEBTN_X+3, TRACEBTN_Y+3, (uint8_t *)"Trace", LEFT_MODE);
+
+	// title
+	BSP_LCD_SetFont(&Font24);
+	BSP_LCD_SetBackColor(LCD_COLOR_DARKMAGENTA);
+	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+	BSP_LCD_DisplayStringAt(TITLE_X, TITLE_Y, (uint8_t *)"CPU LOAD", LEFT_MODE);
+
+	loadwindow_update();
+}
+
+/**
+ * @brief Redraw the numbers and histograms
+ *        with the latest profile, call this
+ *        on each UI tick while it's up.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void loadwindow_update(void)
+{
+	ProfileStats stats;
+
+	// column titles, times are in us
+	BSP_LCD_SetFont(&Font12);
+	BSP_LCD_SetBackColor(LCD_COLOR_DARKMAGENTA);
+	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+	sprintf(row_text, "budget %luus ", (unsigned long)profile_toMicros(profile_getBudget()));
+	BSP_LCD_DisplayStringAt(NAME_X, HEADER_Y, (uint8_t *)row_text, LEFT_MODE);
+	BSP_LCD_DisplayStringAt(AVG_X, HEADER_Y, (uint8_t *)"avg us", LEFT_MODE);
+	BSP_LCD_DisplayStringAt(MAX_X, HEADER_Y, (uint8_t *)"max us", LEFT_MODE);
+	BSP_LCD_DisplayStringAt(LOAD_X, HEADER_Y, (uint8_t *)"max", LEFT_MODE);
+	BSP_LCD_DisplayStringAt(HIST_X, HEADER_Y, (uint8_t *)"0  share of budget  1", LEFT_MODE);
+
+	// each effect, then the whole block
+	for(int i = 0; i < EFFECT_NUM; i++)
+	{
+		// one that couldn't be made never runs
+		if(registry_effects[i])
+			engine_getProfile(registry_effects[i], &stats);
+		else
+			profile_reset(&stats);
+
+		draw_row(i, registry_labels[i], &stats);
+	}
+
+	engine_getProfile(NULL, &stats);
+	draw_row(EFFECT_NUM, "Block", &stats);
+}
+
+/**
+ * @brief Handle touch event on the load window
+ *
+ * @param x X position of touch
+ * @param y Y position of touch
+ *
+ * @retval None
+ */
+void loadwindow_handletouch(int x, int y)
+{
+	// BACKBTN -> go to main page
+	if(y >= BACKBTN_Y && y <= BACKBTN_Y+BACKBTN_H)
+	{
+		if(x >= BACKBTN_X && x <= BACKBTN_X+BACKBTN_W)
+			SetWindow(MAIN_WINDOW);
+		else if(x >= RESETBTN_X && x <= RESETBTN_X+RESETBTN_W)
+		{
+			engine_resetProfile();
+			loadwindow_update();
+		}
+		// dump the trace out of the UART
+		else if(x >= TRACEBTN_X && x <= TRACEBTN_X+TRACEBTN_W)
+			trace_requestDump();
+	}
+}
@@ -0,0 +1,54 @@
+/**
+ * ========================
+ * File: loadwindow.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: CPU load window, shows
+ * how much of the block budget
+ * each effect and the whole
+ * block take, from the engine
+ * profile. It's redrawn on each
+ * UI tick while it's up.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __LOAD_WINDOW_H_
+#define __LOAD_WINDOW_H_
+
+#include "main.h"
+
+/**
+ * @brief Draw the load window
+ *        onto the GLCD.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void loadwindow_draw(void);
+
+/**
+ * @brief Redraw the numbers and histograms
+ *        with the latest profile, call this
+ *        on each UI tick while it's up.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void loadwindow_update(void);
+
+/**
+ * @brief Handle touch event on the load window
+ *
+ * @param x X position of touch
+ * @param y Y position of touch
+ *
+ * @retval None
+ */
+void loadwindow_handletouch(int x, int y);
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * ========================
+ * File: mailbox.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Hands effect parameters
+ * from the UI task to the audio
+ * task. The writer bumps a
+ * sequence count either side of
+ * the copy, the reader gives up
+ * if the count moved or was odd
+ * while it copied and tries again
+ * next block. So the audio task
+ * always gets a whole set of
+ * parameters, never waits on the
+ * writer, and nobody turns
+ * interrupts off.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "mailbox.h"
+
+/**
+ * @brief Empty a mailbox, the reader will
+ *        take nothing until the first post.
+ *
+ * @param mailbox The mailbox
+ *
+ * @retval None
+ */
+void mailbox_init(ParamMailbox* mailbox)
+{
+	memset(mailbox, 0, sizeof(ParamMailbox));
+}
+
+/**
+ * @brief Post a new set of values,
+ *        writer side.
+ *
+ * @param mailbox The mailbox
+ * @param values Values to post
+ * @param count Number of values
+ *
+ * @retval None
+ */
+void mailbox_post(ParamMailbox* mailbox, const float* values, int count)
+{
+	if(count > MAILBOX_VALUES_MAX)
+		count = MAILBOX_VALUES_MAX;
+
+	// odd, the reader knows we're writing
+	mailbox->sequence++;
+	__DMB();
+
+	for(int i = 0; i < count; i++)
+		mailbox->values[i] = values[i];
+
+	// even again, values are all there
+	__DMB();
+	mailbox->sequence++;
+}
+
+/**
+ * @brief Take the latest set of values if
+ *        there is a new one, reader side.
+ *        Never waits, if a post is in
+ *        progress nothing is taken and the
+ *        next call picks it up.
+ *
+ * @param mailbox The mailbox
+ * @param values Where to put the values, left
+ *        alone if there is nothing new
+ * @param count Number of values
+ *
+ * @retval 1 if new values were taken, 0 if not
+ */
+AUDIO_ITCM int mailbox_fetch(ParamMailbox* mailbox, float* values, int count)
+{
+	float copy[MAILBOX_VALUES_MAX];
+	uint32_t before, after;
+
+	if(count > MAILBOX_VALUES_MAX)
+		count = MAILBOX_VALUES_MAX;
+
+	before = mailbox->sequence;
+	if(before == mailbox->taken)
+		return 0;
+
+	// the writer is a task we may have preempted, so
+	// spinning here would never end. keep last blocks
+	// values and look again next block
+	if(before & 1)
+		return 0;
+
+	__DMB();
+	for(int i = 0; i < count; i++)
+		copy[i] = mailbox->values[i];
+	__DMB();
+
+	after = mailbox->sequence;
+	if(before != after)
+		return 0;
+
+	for(int i = 0; i < count; i++)
+		values[i] = copy[i];
+	mailbox->taken = before;
+
+	return 1;
+}
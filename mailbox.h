@@ -0,0 +1,85 @@
+/**
+ * ========================
+ * File: mailbox.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Hands effect parameters
+ * from the UI task to the audio
+ * task. The writer bumps a
+ * sequence count either side of
+ * the copy, the reader gives up
+ * if the count moved or was odd
+ * while it copied and tries again
+ * next block. So the audio task
+ * always gets a whole set of
+ * parameters, never waits on the
+ * writer, and nobody turns
+ * interrupts off.
+ *
+ * Only one writer. The reader may
+ * preempt the writer mid post, it
+ * just keeps the values it had.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __MAILBOX_H
+#define __MAILBOX_H
+
+#include "main.h"
+#include "stdint.h"
+
+// most values a mailbox holds
+#define MAILBOX_VALUES_MAX 8
+
+/**
+ * @brief A parameter mailbox
+ */
+typedef struct
+{
+	volatile uint32_t sequence; // odd while being written
+	float values[MAILBOX_VALUES_MAX];
+	uint32_t taken;             // sequence the reader has, reader only
+}ParamMailbox;
+
+/**
+ * @brief Empty a mailbox, the reader will
+ *        take nothing until the first post.
+ *
+ * @param mailbox The mailbox
+ *
+ * @retval None
+ */
+void mailbox_init(ParamMailbox* mailbox);
+
+/**
+ * @brief Post a new set of values,
+ *        writer side.
+ *
+ * @param mailbox The mailbox
+ * @param values Values to post
+ * @param count Number of values
+ *
+ * @retval None
+ */
+void mailbox_post(ParamMailbox* mailbox, const float* values, int count);
+
+/**
+ * @brief Take the latest set of values if
+ *        there is a new one, reader side.
+ *        Never waits, if a post is in
+ *        progress nothing is taken and the
+ *        next call picks it up.
+ *
+ * @param mailbox The mailbox
+ * @param values Where to put the values, left
+ *        alone if there is nothing new
+ * @param count Number of values
+ *
+ * @retval 1 if new values were taken, 0 if not
+ */
+int mailbox_fetch(ParamMailbox* mailbox, float* values, int count);
+
+#endif
@@ -9,43 +9,63 @@
  * Where the guts of the
  * firmware lies.
  *
- * Last Updated: 04/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
  */
-#include "distortion.h"
 #include "main.h"
-#include "wahwah.h"
-#include "vibrato.h"
-#include "delay.h"
-#include "tremolo.h"
-#include "flanger.h"
+#include "registry.h"
 #include "mainwindow.h"
-
-typedef enum
-{
-  BUFFER_OFFSET_NONE = 0,
-  BUFFER_OFFSET_HALF = 1,
-  BUFFER_OFFSET_FULL = 2,
-}BUFFER_StateTypeDef;
+#include "loadwindow.h"
+#include "engine.h"
+#include "boot.h"
 
 // handle for initialising timer
 TIM_HandleTypeDef htim10;
 
+// handle for the UART printf goes out on,
+// the ST-LINK virtual COM port
+UART_HandleTypeDef huart1;
+
 // static functions
 static void SystemClock_Init(void);
 static void TIM10_Init(void);
+static void UART_Init(void);
+static void TCM_Init(void);
+static void Audio_Task(void* arg);
+static void UI_Task(void* arg);
+static void Telemetry_Task(void* arg);
+
+/**
+ * @brief A touch on the screen, one is sent
+ *        for each timer tick it's held down
+ */
+typedef struct
+{
+	uint16_t x;
+	uint16_t y;
+}TouchEvent;
 
 // static vars
 static TS_StateTypeDef ts_state;
-static uint8_t audio_rec_buffer_state;
-// look up table, window enum is our key
-static Effect** effects; 
+// window we're on, for effect windows
+// this is the key into registry_effects
 static int8_t current_window;
 
-// these buffers will hold all of our previous audio data
-static uint16_t audio_in_buffer[AUDIO_BUFFER_SIZE];
-static uint16_t audio_out_buffer[AUDIO_BUFFER_SIZE];
+// set by the timer, the UI task reads
+// the touch screen when it sees it
+static volatile uint8_t ui_tick;
+
+// touches waiting for the UI task
+#define TOUCH_QUEUE_SIZE 8
+static TaskQueue touch_queue;
+static TouchEvent touch_items[TOUCH_QUEUE_SIZE];
+
+// engine stats from the audio task to
+// the telemetry task, about once a second
+#define TELEMETRY_QUEUE_SIZE 4
+static TaskQueue telemetry_queue;
+static EngineStats telemetry_items[TELEMETRY_QUEUE_SIZE];
 
 /**
  *
@@ -123,43 +143,192 @@ static void TIM10_Init(void)
 }
 
 /**
- * @brief Call backs for our DMA transfers
- *        Change audio buffer state accordingly
- * 
- * @param None
+ *
+ * @brief Initialise the UART on the ST-LINK
+ *        virtual COM port, 115200 8N1.
+ *        printf goes out on it.
+ *
+ * @param  None
  *
  * @retval None
- * 
+ *
  */
-void BSP_AUDIO_IN_TransferComplete_CallBack(void)
+static void UART_Init(void)
 {
-  audio_rec_buffer_state = BUFFER_OFFSET_FULL;
-  return;
+  huart1.Init.BaudRate = 115200;
+  huart1.Init.WordLength = UART_WORDLENGTH_8B;
+  huart1.Init.StopBits = UART_STOPBITS_1;
+  huart1.Init.Parity = UART_PARITY_NONE;
+  huart1.Init.Mode = UART_MODE_TX_RX;
+  huart1.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+  BSP_COM_Init(COM1, &huart1);
 }
-/*
-* @param None
-*
-* @retval None
-*/
-void BSP_AUDIO_IN_HalfTransfer_CallBack(void)
+
+/**
+ *
+ * @brief Send a character for printf, from
+ *        _write() in syscalls.c. Blocks, so
+ *        only print from the tasks under audio.
+ *
+ * @param  ch Character to send
+ *
+ * @retval The character
+ *
+ */
+int __io_putchar(int ch)
 {
-  audio_rec_buffer_state = BUFFER_OFFSET_HALF;
-  return;
+	uint8_t c = ch;
+
+	HAL_UART_Transmit(&huart1, &c, 1, HAL_MAX_DELAY);
+	return ch;
 }
-/*
-* @param None
-*
-* @retval None
-*/
-void BSP_AUDIO_IN_Error_CallBack(void)
+
+/**
+ *
+ * @brief Copy the audio hot path from flash
+ *        into ITCM, has to run before any
+ *        AUDIO_ITCM function is called.
+ *
+ * @param  None
+ *
+ * @retval None
+ *
+ */
+static void TCM_Init(void)
 {
-	return;
+	// from the linker script
+	extern uint32_t _siitcm, _sitcm, _eitcm;
+
+	memcpy(&_sitcm, &_siitcm, (uint8_t*)&_eitcm - (uint8_t*)&_sitcm);
+}
+
+/**
+ *
+ * @brief Audio task, processes the blocks the
+ *        DMA has filled and sends the stats
+ *        on to telemetry about once a second.
+ *
+ * @param  arg Not used
+ *
+ * @retval None
+ *
+ */
+static AUDIO_ITCM void Audio_Task(void* arg)
+{
+	static uint32_t reported;
+	static uint8_t playing;
+	EngineStats stats;
+
+	engine_service();
+
+	engine_getStats(&stats);
+	if(!playing && stats.blocks)
+	{
+		playing = 1;
+		boot_firstAudio();
+	}
+
+	if(stats.blocks - reported >= engine_getSampleRate() / engine_getBlockFrames())
+	{
+		reported = stats.blocks;
+		task_send(&telemetry_queue, &stats);
+	}
+}
+
+/**
+ *
+ * @brief UI task, reads the touch screen on
+ *        each timer tick and hands the touches
+ *        to the window we're on, which redraws.
+ *        Audio keeps playing, the audio task
+ *        breaks into this whenever a block is in.
+ *
+ * @param  arg Not used
+ *
+ * @retval None
+ *
+ */
+static void UI_Task(void* arg)
+{
+	TouchEvent touch;
+
+	if(ui_tick)
+	{
+		ui_tick = 0;
+
+		// the load window keeps up with the profile
+		if(current_window == LOAD_WINDOW)
+		{
+			trace_event(TRACE_DRAW_START, (uint16_t)LOAD_WINDOW);
+			loadwindow_update();
+			trace_event(TRACE_DRAW_END, (uint16_t)LOAD_WINDOW);
+		}
+
+		// the codec is on the same I2C bus, keep the
+		// audio task off it until the read is done
+		trace_event(TRACE_TOUCH_READ_START, 0);
+		task_lockAudio();
+		BSP_TS_GetState(&ts_state);
+		task_unlockAudio();
+		trace_event(TRACE_TOUCH_READ_END, 0);
+
+		if(ts_state.touchDetected)
+		{
+			touch.x = ts_state.touchX[0];
+			touch.y = ts_state.touchY[0];
+			task_send(&touch_queue, &touch);
+		}
+	}
+
+	while(task_receive(&touch_queue, &touch))
+	{
+		trace_event(TRACE_TOUCH_START, touch.x);
+
+		if(current_window == MAIN_WINDOW)
+			mainwindow_handletouch(touch.x, touch.y);
+		else if(current_window == LOAD_WINDOW)
+			loadwindow_handletouch(touch.x, touch.y);
+		else if(registry_effects[current_window])
+			effect_handletouch(registry_effects[current_window], touch.x, touch.y);
+
+		trace_event(TRACE_TOUCH_END, touch.x);
+	}
+}
+
+/**
+ *
+ * @brief Telemetry task, prints the engine
+ *        stats the audio task sends, and the
+ *        trace when a dump is asked for.
+ *
+ * @param  arg Not used
+ *
+ * @retval None
+ *
+ */
+static void Telemetry_Task(void* arg)
+{
+	EngineStats stats;
+
+	while(task_receive(&telemetry_queue, &stats))
+	{
+		printf("blocks %lu load %d%% peak %d%% overruns %lu underruns %lu recoveries %lu\r\n",
+				(unsigned long)stats.blocks,
+				(int)stats.load,
+				(int)stats.loadPeak,
+				(unsigned long)stats.overruns,
+				(unsigned long)stats.underruns,
+				(unsigned long)stats.recoveries);
+	}
+
+	trace_service();
 }
 
 /*
  * @brief Interrupt routine for our Timer.
- *        Handles any touch screen presses
- *        and updates UI accordingly.
+ *        Wakes the UI task to look for
+ *        touches, all the work is done there.
  * 
  * @param  None
  *
@@ -170,19 +339,9 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
 	if(htim->Instance == TIM10)
 	{
-		BSP_TS_GetState(&ts_state);
-
-		if(ts_state.touchDetected)
-		{
-			BSP_AUDIO_OUT_SetMute(AUDIO_MUTE_ON);
-
-			if(current_window == MAIN_WINDOW)
-				mainwindow_handletouch(ts_state.touchX[0], ts_state.touchY[0]);
-			else
-				effect_handletouch(effects[current_window], ts_state.touchX[0], ts_state.touchY[0]);
-
-			BSP_AUDIO_OUT_SetMute(AUDIO_MUTE_OFF);
-		}
+		trace_event(TRACE_TICK, 0);
+		ui_tick = 1;
+		task_signal(TASK_UI);
 	}
 }
 
@@ -199,18 +358,42 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
  */
 void SetWindow(int8_t windowName)
 {
+	// an effect that couldn't be made has no window
+	if(windowName >= 0 && windowName < EFFECT_NUM && registry_effects[windowName] == NULL)
+		return;
+
 	current_window = windowName;
 
+	trace_event(TRACE_DRAW_START, (uint16_t)windowName);
+
 	if(current_window == MAIN_WINDOW)
-	{
 		mainwindow_draw();
-		return;
-	}
-
+	else if(current_window == LOAD_WINDOW)
+		loadwindow_draw();
 	// must be in bounds of enum
-	if( windowName >= WAHWAH_WINDOW
-	 && windowName <= TREMOLO_WINDOW)
-		effect_draw(effects[current_window]);
+	else if(windowName >= 0 && windowName < EFFECT_NUM)
+		effect_draw(registry_effects[current_window]);
+
+	trace_event(TRACE_DRAW_END, (uint16_t)windowName);
+}
+
+/**
+ * @brief Stop everything, for when the
+ *        firmware can't go on. Report what
+ *        went wrong before calling it.
+ *
+ * @param None
+ *
+ * @retval None, never returns
+ */
+void Error_Handler(void)
+{
+	// the report has gone out on the UART,
+	// stay here for the debugger
+	__disable_irq();
+	while(1)
+	{
+	}
 }
 
 /**
@@ -223,126 +406,79 @@ void SetWindow(int8_t windowName)
  */
 int main(void)
 {
+	// audio code into ITCM before anything runs it
+	TCM_Init();
+
 	// Enable CPU Cache for speed
 	SCB_EnableICache();
 	SCB_EnableDCache();
 
-	// Initialise peripherals
+	boot_start();
+
+	// Initialise the core
 	HAL_Init();
 	SystemClock_Init();
-	TIM10_Init();
+	UART_Init();
+	boot_mark(BOOT_CLOCKS);
+
+	// memory for the effects and engine, SDRAM
+	// has to be up before anything is taken
 	BSP_SDRAM_Init();
+	arena_init();
+	trace_init();
+	boot_mark(BOOT_MEMORY);
+
+	// tasks, the audio task has to be
+	// set before the DMA can wake it
+	task_queueInit(&touch_queue, touch_items, sizeof(TouchEvent), TOUCH_QUEUE_SIZE, TASK_UI);
+	task_queueInit(&telemetry_queue, telemetry_items, sizeof(EngineStats), TELEMETRY_QUEUE_SIZE, TASK_TELEMETRY);
+	task_set(TASK_AUDIO, Audio_Task, NULL);
+
+	// start the codec streaming with no effects, so
+	// the guitar is heard straight through while the
+	// rest comes up. the audio task runs from PendSV
+	// and breaks into everything below
+	engine_init(NULL, 0);
+	engine_start();
+	boot_mark(BOOT_AUDIO);
+
+	// the touch screen is on the codecs I2C bus
+	TIM10_Init();
+	task_lockAudio();
 	BSP_TS_Init(480, 270);
+	task_unlockAudio();
 	BSP_LCD_Init();
 	BSP_LCD_LayerDefaultInit(LTDC_ACTIVE_LAYER, LCD_FRAME_BUFFER);
 	BSP_LCD_DisplayOn();
 	BSP_LCD_SelectLayer(LTDC_ACTIVE_LAYER);
+	boot_mark(BOOT_DISPLAY);
+
+	// initialise our effects, each one once, and
+	// hand them to the engine. they all start off
+	// so it carries on straight through
+	registry_init();
+	engine_setOrder(registry_effects, EFFECT_NUM);
+	boot_mark(BOOT_EFFECTS);
 
 	// be on the main window at first
 	current_window = MAIN_WINDOW;
 
-	// initialise our effects
-	distortion_init();
-	tremolo_init();
-	tremolo_init();
-	wahwah_init();
-	flanger_init();
-	delay_init();
-	vibrato_init();
-
-	// fill effect buffer so we can use it
-	// for rendering UI based on enum value.
-	effects[DISTORTION_WINDOW] = &distortion;
-	effects[TREMOLO_WINDOW] = &tremolo;
-	effects[WAHWAH_WINDOW] = &wahwah;
-	effects[FLANGER_WINDOW] = &flanger;
-	effects[DELAY_WINDOW] = &delay;
-	effects[VIBRATO_WINDOW] = &vibrato;
-
 	// initialise main window
 	mainwindow_init();
 
-	// start our timer
-	HAL_TIM_Base_Start_IT(&htim10);
-
 	mainwindow_draw();
 
-	BSP_AUDIO_IN_OUT_Init(
-			INPUT_DEVICE_INPUT_LINE_1,
-			OUTPUT_DEVICE_HEADPHONE,
-			I2S_AUDIOFREQ_44K ,
-			DEFAULT_AUDIO_IN_BIT_RESOLUTION,
-			DEFAULT_AUDIO_IN_CHANNEL_NBR);
-
-	// audio buffers, make sure there clean
-	memset((uint16_t*)AUDIO_BUFFER_IN, 0, AUDIO_BLOCK_SIZE*2);
-	memset((uint16_t*)AUDIO_BUFFER_OUT, 0, AUDIO_BLOCK_SIZE*4);
-	memset(audio_in_buffer, 0, AUDIO_BUFFER_SIZE);
-	memset(audio_out_buffer, 0, AUDIO_BUFFER_SIZE);
-
-	audio_rec_buffer_state = BUFFER_OFFSET_NONE;
-
-	// start the audio loop back using the BSP audio drivers
-	BSP_AUDIO_IN_Record((uint16_t*)AUDIO_BUFFER_IN, AUDIO_BLOCK_SIZE);
-	BSP_AUDIO_OUT_SetAudioFrameSlot(CODEC_AUDIOFRAME_SLOT_02);
-	BSP_AUDIO_OUT_Play((uint16_t*)AUDIO_BUFFER_OUT, AUDIO_BLOCK_SIZE*4);
-	BSP_AUDIO_OUT_SetMute(AUDIO_MUTE_OFF);
+	task_set(TASK_UI, UI_Task, NULL);
+	task_set(TASK_TELEMETRY, Telemetry_Task, NULL);
 
-	// 70 is our default volume
-	BSP_AUDIO_OUT_SetVolume(70);
-
-	// so we know which state to wait for next
-	uint8_t next_state = BUFFER_OFFSET_HALF;
-
-	// buffer to send our processed data to.
-	// points to the buffer the Audio codec will play
-	uint16_t* buffer;
-
-	// offset in our large audio buffer
-	uint16_t offset     = 0;
-	uint32_t block_cont = 0;
-
-	while (1)
-	{
-		// incremenet offset
-		offset = (block_cont*AUDIO_BLOCK_SIZE/2);
-
-		// wait for next state
-		while(audio_rec_buffer_state != next_state) continue;//HAL_Delay(1);
-
-		// first copy input audio block to large audio buffer
-		// if half_offset we are getting first DMA buffer
-		// if full_offset we are getting second DMA buffer
-		if(audio_rec_buffer_state == BUFFER_OFFSET_HALF)
-		{
-			memcpy((uint16_t*)(audio_in_buffer+offset),(uint16_t*)(AUDIO_BUFFER_IN),AUDIO_BLOCK_SIZE);
-			buffer = (uint16_t *)AUDIO_BUFFER_OUT;
-			next_state = BUFFER_OFFSET_FULL;
-		}
-		else
-		{
-			memcpy((uint16_t*)(audio_in_buffer+offset),(uint16_t *)(AUDIO_BUFFER_IN+(AUDIO_BLOCK_SIZE)),AUDIO_BLOCK_SIZE);
-			buffer = (uint16_t *)(AUDIO_BUFFER_OUT + (AUDIO_BLOCK_SIZE*2));
-			next_state = BUFFER_OFFSET_HALF;
-
-		}
-
-		memcpy((uint16_t*)(audio_out_buffer+offset),(uint16_t *)(audio_in_buffer+offset),AUDIO_BLOCK_SIZE);
-
-		// process our audio with our effects
-		for(int i = 0; i < 6; i++)
-			effects[i]->processBuffer(audio_in_buffer, audio_out_buffer, offset);
+	// start our timer, it only wakes the UI task
+	HAL_TIM_Base_Start_IT(&htim10);
+	boot_mark(BOOT_UI);
 
-		// send the processed audio to our output buffer
-		int m = 0;
-		for(int i = 0; i < AUDIO_BLOCK_SIZE/2; i++)
-		{
-			buffer[m] = audio_out_buffer[i+offset];
-			buffer[m+1] = audio_out_buffer[i+offset];
-			m += 2;
-		}
+	arena_report();
+	boot_report();
 
-		// make sure to wrap around to 0
-		block_cont = (block_cont == 351) ? 0 : block_cont + 1;
-	}
+	// run the tasks, the audio task as the DMA fills
+	// blocks, sleeping in between. never returns.
+	task_start();
 }
@@ -8,7 +8,7 @@
  * that we might need to use
  * in other files.
  *
- * Last Updated: 04/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
  */
@@ -19,30 +19,35 @@
 extern "C" {
 #endif
 
+#ifdef HOST_SIM
+#include "hostsim.h"
+#else
 #include "stm32f7xx_hal.h"
 #include "stm32746g_discovery.h"
 #include "stm32746g_discovery_sdram.h"
 #include "stm32746g_discovery_ts.h"
 #include "stm32746g_discovery_lcd.h"
 #include "stm32746g_discovery_audio.h"
+#endif
 
 #include <stdio.h>
 #include "math.h"
+#include "effectlist.h"
 
 /**
  * @brief Use this enum as an 
  *        index into the lookup 
- *		  table found in main.c
+ *		  table found in registry.c,
+ *        one window per effect in
+ *        effectlist.h
 */
 typedef enum
 {
+	LOAD_WINDOW = -2,
 	MAIN_WINDOW = -1,
-	WAHWAH_WINDOW = 0,
-	DISTORTION_WINDOW = 1,
-	FLANGER_WINDOW = 2,
-	VIBRATO_WINDOW = 3,
-	DELAY_WINDOW = 4,
-	TREMOLO_WINDOW = 5,
+#define EFFECT_WINDOW_ENUM(name, NAME, label) NAME##_WINDOW = EFFECT_##NAME,
+	EFFECT_LIST(EFFECT_WINDOW_ENUM)
+#undef EFFECT_WINDOW_ENUM
 }CURRENT_WINDOW_StateTypeDef;
 
 /**
@@ -58,20 +63,54 @@ typedef enum
  */
 void SetWindow(int8_t windowName);
 
-#define RGB565_BYTE_PER_PIXEL 2
+/**
+ * @brief Stop everything, for when the
+ *        firmware can't go on. Report what
+ *        went wrong before calling it.
+ *
+ * @param None
+ *
+ * @retval None, never returns
+ */
+void Error_Handler(void);
+
 #define ARBG8888_BYTE_PER_PIXEL 4
-#define CAMERA_RES_MAX_X 640
-#define CAMERA_RES_MAX_Y 480
-#define AUDIO_BLOCK_SIZE ((uint32_t)256)
-#define AUDIO_BUFFER_SIZE ((uint32_t)45056)
-#define AUDIO_BUFFER_IN AUDIO_REC_START_ADDR
-#define AUDIO_BUFFER_OUT (AUDIO_REC_START_ADDR + (AUDIO_BLOCK_SIZE * 2))
+// block size is picked at runtime from the latency
+// menu, 16 to 256 frames in powers of 2. one DMA half
+// is 2 channels of a block, record and playback
+// buffers are 2 halves each, sized for the biggest block.
+#define AUDIO_BLOCK_FRAMES_MIN ((uint32_t)16)
+#define AUDIO_BLOCK_FRAMES_MAX ((uint32_t)256)
+#define AUDIO_BLOCK_FRAMES_DEFAULT ((uint32_t)128)
+#define AUDIO_DMA_BUFFER_BYTES (AUDIO_BLOCK_FRAMES_MAX * 2 * 2 * sizeof(uint16_t))
+// sample rate is picked at runtime too, effects work
+// out their coefficients from it. lines are sized for
+// the highest rate.
+#define AUDIO_SAMPLE_RATE_DEFAULT ((uint32_t)44100)
+#define AUDIO_SAMPLE_RATE_MAX ((uint32_t)96000)
+// guitar goes into the left input, the engine copies it to
+// both channels and effects can make it stereo. set to 0
+// to take both input channels as they are.
+#ifndef AUDIO_INPUT_MONO
+#define AUDIO_INPUT_MONO 1
+#endif
+// the audio hot path runs from ITCM and the state it
+// works on sits in DTCM, off the caches so a screen
+// redraw can't push them out. see the linker script.
+// AUDIO_DTCM memory isn't zeroed at startup.
+#ifdef HOST_SIM
+#define AUDIO_ITCM
+#define AUDIO_DTCM
+#else
+#define AUDIO_ITCM __attribute__((section(".itcm_text")))
+#define AUDIO_DTCM __attribute__((section(".dtcm_bss")))
+#endif
+#ifndef HOST_SIM
+// the LCD frame buffer is at the bottom of SDRAM,
+// the SDRAM arena starts straight after it
 #define LCD_FRAME_BUFFER SDRAM_DEVICE_ADDR
-#define CAMERA_FRAME_BUFFER ((uint32_t)(LCD_FRAME_BUFFER + (RK043FN48H_WIDTH * RK043FN48H_HEIGHT * ARBG8888_BYTE_PER_PIXEL)))
-#define SDRAM_WRITE_READ_ADDR ((uint32_t)(CAMERA_FRAME_BUFFER + (CAMERA_RES_MAX_X * CAMERA_RES_MAX_Y * RGB565_BYTE_PER_PIXEL)))
-#define SDRAM_WRITE_READ_ADDR_OFFSET ((uint32_t)0x0800)
-#define SRAM_WRITE_READ_ADDR_OFFSET SDRAM_WRITE_READ_ADDR_OFFSET
-#define AUDIO_REC_START_ADDR SDRAM_WRITE_READ_ADDR
+#define LCD_FRAME_BUFFER_BYTES ((uint32_t)(RK043FN48H_WIDTH * RK043FN48H_HEIGHT * ARBG8888_BYTE_PER_PIXEL))
+#endif
 
 #ifdef __cplusplus
 }
@@ -12,12 +12,14 @@
  * main window is where volume
  * control will take place.
  *
- * Last Updated: 04/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
  */
 
 #include "mainwindow.h"
+#include "engine.h"
+#include "registry.h"
 
 // Use macros to define UI
 // widget locations.
@@ -27,7 +29,7 @@
 #define EFFECT_BOX_H 38
 #define EFFECT_BOX_SPACE 28
 #define VOL_TILTE_X EFFECT_BOX_X
-#define VOL_TITLE_Y EFFECT_BOX_Y+((EFFECT_BOX_SPACE)*6)
+#define VOL_TITLE_Y (EFFECT_BOX_Y+((EFFECT_BOX_SPACE)*EFFECT_NUM))
 #define VOL_VALUE_X VOL_TILTE_X+120+5
 #define VOL_VALUE_Y VOL_TITLE_Y
 #define VOL_BTN_W (EFFECT_BOX_W/2)-5
@@ -36,15 +38,29 @@
 #define VOL_BTN2_X VOL_BTN1_X+VOL_BTN_W+10
 #define VOL_BTN1_Y VOL_VALUE_Y
 #define VOL_BTN2_Y VOL_VALUE_Y
+#define LATENCY_BTN_X 480-125
+#define LATENCY_BTN_Y 5
+#define LATENCY_BTN_W 120
+#define LATENCY_BTN_H 38
+#define RATE_BTN_X 5
+#define RATE_BTN_Y LATENCY_BTN_Y
+#define RATE_BTN_W 90
+#define RATE_BTN_H LATENCY_BTN_H
+#define LOAD_BTN_X VOL_BTN2_X+VOL_BTN_W+10
+#define LOAD_BTN_Y VOL_BTN1_Y
+#define LOAD_BTN_W 480-(LOAD_BTN_X)-5
+#define LOAD_BTN_H VOL_BTN_H
 
 // names for each effect button
 // index of name should be the enum value
-static char button_names[6][14];
+static char button_names[EFFECT_NUM][14];
 
 // static vars
 // to keep track of volume
 static int master_volume = 70;
 static char volume_text[30];
+static char latency_text[30];
+static char rate_text[30];
 
 /**
  * @brief This function will update the volume
@@ -64,7 +80,7 @@ static void update_volume(int newVolume)
 	master_volume = fmaxf(0.0f, fminf(100.0f, newVolume));
 
 	// set the volume
-	BSP_AUDIO_OUT_SetVolume(master_volume);
+	engine_setVolume(master_volume);
 
 	// update the volume text
 	BSP_LCD_SetFont(&Font24);
@@ -75,6 +91,52 @@ static void update_volume(int newVolume)
 }
 
 
+/**
+ * @brief Draw the latency menu button,
+ *        shows the block size and how
+ *        long one block takes to play.
+ *
+ * @param None
+ *
+ * @retval None
+ *
+ */
+static void draw_latency(void)
+{
+	uint32_t frames = engine_getBlockFrames();
+
+	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+	BSP_LCD_FillRect(LATENCY_BTN_X, LATENCY_BTN_Y, LATENCY_BTN_W, LATENCY_BTN_H);
+
+	BSP_LCD_SetFont(&Font16);
+	BSP_LCD_SetBackColor(LCD_COLOR_WHITE);
+	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
+	sprintf(latency_text, "Block %lu", (unsigned long)frames);
+	BSP_LCD_DisplayStringAt(LATENCY_BTN_X+3, LATENCY_BTN_Y+3, (uint8_t *)latency_text, LEFT_MODE);
+	sprintf(latency_text, "%.1fms", (frames*1000.0f)/engine_getSampleRate());
+	BSP_LCD_DisplayStringAt(LATENCY_BTN_X+3, LATENCY_BTN_Y+20, (uint8_t *)latency_text, LEFT_MODE);
+}
+
+/**
+ * @brief Draw the sample rate button.
+ *
+ * @param None
+ *
+ * @retval None
+ *
+ */
+static void draw_rate(void)
+{
+	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+	BSP_LCD_FillRect(RATE_BTN_X, RATE_BTN_Y, RATE_BTN_W, RATE_BTN_H);
+
+	BSP_LCD_SetFont(&Font16);
+	BSP_LCD_SetBackColor(LCD_COLOR_WHITE);
+	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
+	sprintf(rate_text, "%.1fkHz", engine_getSampleRate()/1000.0f);
+	BSP_LCD_DisplayStringAt(RATE_BTN_X+3, RATE_BTN_Y+11, (uint8_t *)rate_text, LEFT_MODE);
+}
+
 /**
  * @brief Intialise the main window!
  *        We are simply filling the button_names
@@ -87,12 +149,8 @@ static void update_volume(int newVolume)
  */
 void mainwindow_init(void)
 {
-	sprintf(button_names[DISTORTION_WINDOW],"DISTORTION");
-	sprintf(button_names[FLANGER_WINDOW],"FLANGER");
-	sprintf(button_names[VIBRATO_WINDOW],"VIBRATO");
-	sprintf(button_names[DELAY_WINDOW],"DELAY");
-	sprintf(button_names[TREMOLO_WINDOW],"TREMOLO");
-	sprintf(button_names[WAHWAH_WINDOW],"WAHWAH");
+	for(int i = 0; i < EFFECT_NUM; i++)
+		sprintf(button_names[i], "%.13s", registry_labels[i]);
 }
 
 /**
@@ -119,8 +177,8 @@ void mainwindow_draw(void)
 	// background for the buttons
 	BSP_LCD_SetBackColor(LCD_COLOR_WHITE);
 
-	// 3 rows of effects, 2 on each row.
-	for(int i = 0; i < 6; i+=2)
+	// rows of effects, 2 on each row.
+	for(int i = 0; i < EFFECT_NUM; i+=2)
 	{
 		// calculate UI position based on effect number
 		int BtnY  = EFFECT_BOX_Y+((EFFECT_BOX_SPACE)*i);
@@ -129,13 +187,21 @@ void mainwindow_draw(void)
 		int BtnW  = EFFECT_BOX_W;
 		int BtnH  = EFFECT_BOX_H;
 
-		// display effect buttons
-		BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+		// display effect buttons, grey if the
+		// effect couldn't be made
+		BSP_LCD_SetTextColor(registry_effects[i] ? LCD_COLOR_WHITE : LCD_COLOR_GRAY);
 		BSP_LCD_FillRect(BtnX, BtnY, BtnW, BtnH);
+		BSP_LCD_SetBackColor(registry_effects[i] ? LCD_COLOR_WHITE : LCD_COLOR_GRAY);
 		BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
 		BSP_LCD_DisplayStringAt(10,BtnY,(uint8_t *)button_names[i],LEFT_MODE);
-		BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+
+		// odd number of effects, last row has one
+		if(i+1 >= EFFECT_NUM)
+			break;
+
+		BSP_LCD_SetTextColor(registry_effects[i+1] ? LCD_COLOR_WHITE : LCD_COLOR_GRAY);
 		BSP_LCD_FillRect(BtnX2,BtnY,EFFECT_BOX_W,EFFECT_BOX_H);
+		BSP_LCD_SetBackColor(registry_effects[i+1] ? LCD_COLOR_WHITE : LCD_COLOR_GRAY);
 		BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
 		BSP_LCD_DisplayStringAt(BtnX2, BtnY,(uint8_t *)button_names[i+1],LEFT_MODE);
 	}
@@ -162,6 +228,18 @@ void mainwindow_draw(void)
 	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
 	sprintf(volume_text,"%d  ",master_volume);
 	BSP_LCD_DisplayStringAt(VOL_VALUE_X, VOL_VALUE_Y, (uint8_t *)volume_text, LEFT_MODE);
+
+	// and the latency menu
+	draw_latency();
+	draw_rate();
+
+	// CPU load window button
+	BSP_LCD_SetTextColor(LCD_COLOR_WHITE);
+	BSP_LCD_FillRect(LOAD_BTN_X, LOAD_BTN_Y, LOAD_BTN_W, LOAD_BTN_H);
+	BSP_LCD_SetFont(&Font16);
+	BSP_LCD_SetBackColor(LCD_COLOR_WHITE);
+	BSP_LCD_SetTextColor(LCD_COLOR_BLACK);
+	BSP_LCD_DisplayStringAt(LOAD_BTN_X+3, LOAD_BTN_Y+11, (uint8_t *)"CPU", LEFT_MODE);
 }
 
 
@@ -176,7 +254,7 @@ void mainwindow_draw(void)
  */
 void mainwindow_handletouch(int x, int y)
 {
-	for(int i = 0; i < 6; i+=2)
+	for(int i = 0; i < EFFECT_NUM; i+=2)
 	{
 		int BtnY  = EFFECT_BOX_Y+(EFFECT_BOX_SPACE*i);
 		int BtnX  = EFFECT_BOX_X;
@@ -186,13 +264,53 @@ void mainwindow_handletouch(int x, int y)
 
 		if(y > BtnY && y < BtnY + BtnH)
 		{
-			if(x > BtnX && x < BtnX + BtnW)
+			// an effect that couldn't be made has no window
+			if(x > BtnX && x < BtnX + BtnW && registry_effects[i])
 				SetWindow(i);
-			if(x > BtnX2 && x < BtnX2 + BtnW)
+			if(x > BtnX2 && x < BtnX2 + BtnW && i+1 < EFFECT_NUM && registry_effects[i+1])
 				SetWindow(i+1);
 		}
 	}
 
+	// latency menu -> step through the block sizes
+	if(y > LATENCY_BTN_Y && y < LATENCY_BTN_Y + LATENCY_BTN_H)
+		if(x > LATENCY_BTN_X && x < LATENCY_BTN_X + LATENCY_BTN_W)
+		{
+			uint32_t frames = engine_getBlockFrames() * 2;
+			if(frames > AUDIO_BLOCK_FRAMES_MAX)
+				frames = AUDIO_BLOCK_FRAMES_MIN;
+
+			engine_setBlockFrames(frames);
+			draw_latency();
+			return;
+		}
+
+	// rate button -> 44.1k, 48k then 96k
+	if(y > RATE_BTN_Y && y < RATE_BTN_Y + RATE_BTN_H)
+		if(x > RATE_BTN_X && x < RATE_BTN_X + RATE_BTN_W)
+		{
+			uint32_t rate = engine_getSampleRate();
+			if(rate == I2S_AUDIOFREQ_44K)
+				rate = I2S_AUDIOFREQ_48K;
+			else if(rate == I2S_AUDIOFREQ_48K)
+				rate = I2S_AUDIOFREQ_96K;
+			else
+				rate = I2S_AUDIOFREQ_44K;
+
+			engine_setSampleRate(rate);
+			draw_rate();
+			draw_latency();
+			return;
+		}
+
+	// CPU button -> load window
+	if(y > LOAD_BTN_Y && y < LOAD_BTN_Y + LOAD_BTN_H)
+		if(x > LOAD_BTN_X && x < LOAD_BTN_X + LOAD_BTN_W)
+		{
+			SetWindow(LOAD_WINDOW);
+			return;
+		}
+
 	if(y > VOL_BTN1_Y && y < VOL_BTN1_Y + VOL_BTN_H)
 	{
 		// - button
@@ -0,0 +1,164 @@
+/**
+ * ========================
+ * File: profile.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Cycle count profiling
+ * for the audio path. Each
+ * effect and the whole block
+ * keep the min, average and
+ * max cycles they took, and a
+ * histogram of how much of the
+ * block budget that was.
+ *
+ * On the board the cycles are
+ * the DWT cycle counter, on the
+ * host the monotonic clock in
+ * cycles of SystemCoreClock.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "profile.h"
+
+// cycles in one block at the block
+// size and rate the engine is on
+static uint32_t budget = 1;
+
+/**
+ * @brief Start the cycle counter, it is never
+ *        reset so anyone can take differences.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void profile_init(void)
+{
+#ifndef HOST_SIM
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * @brief Set how many cycles a block lasts,
+ *        the histogram is in eighths of this.
+ *
+ * @param cycles Cycles in one block
+ *
+ * @retval None
+ */
+void profile_setBudget(uint32_t cycles)
+{
+	budget = cycles ? cycles : 1;
+}
+
+/**
+ * @brief How many cycles a block lasts.
+ *
+ * @param None
+ *
+ * @retval Cycles in one block
+ */
+uint32_t profile_getBudget(void)
+{
+	return budget;
+}
+
+/**
+ * @brief Empty a set of times.
+ *
+ * @param stats The times
+ *
+ * @retval None
+ */
+void profile_reset(ProfileStats* stats)
+{
+	memset(stats, 0, sizeof(ProfileStats));
+}
+
+/**
+ * @brief Record one time.
+ *
+ * @param stats The times
+ * @param cycles Cycles it took
+ *
+ * @retval None
+ */
+AUDIO_ITCM void profile_add(ProfileStats* stats, uint32_t cycles)
+{
+	uint32_t bucket = (uint32_t)(((uint64_t)cycles * PROFILE_BUCKETS) / budget);
+	if(bucket >= PROFILE_BUCKETS)
+		bucket = PROFILE_BUCKETS-1;
+
+	// min starts at 0, the first time sets it
+	if(stats->count == 0 || cycles < stats->min)
+		stats->min = cycles;
+	if(cycles > stats->max)
+		stats->max = cycles;
+
+	stats->total += cycles;
+	stats->count++;
+	stats->buckets[bucket]++;
+}
+
+/**
+ * @brief Average of a set of times.
+ *
+ * @param stats The times
+ *
+ * @retval Cycles, 0 if none recorded
+ */
+uint32_t profile_average(const ProfileStats* stats)
+{
+	if(stats->count == 0)
+		return 0;
+
+	return (uint32_t)(stats->total / stats->count);
+}
+
+/**
+ * @brief Convert cycles to microseconds.
+ *
+ * @param cycles Cycles
+ *
+ * @retval Microseconds
+ */
+uint32_t profile_toMicros(uint32_t cycles)
+{
+	return (uint32_t)(((uint64_t)cycles * 1000000u) / SystemCoreClock);
+}
+
+/**
+ * @brief Print a set of times, min, average
+ *        and max in us and the histogram.
+ *
+ * @param name What was timed
+ * @param stats The times
+ *
+ * @retval None
+ */
+void profile_print(const char* name, const ProfileStats* stats)
+{
+	if(stats->count == 0)
+	{
+		printf("  %-12s not run\r\n", name);
+		return;
+	}
+
+	printf("  %-12s min %5lu avg %5lu max %5lu us %3lu%% |",
+			name,
+			(unsigned long)profile_toMicros(stats->min),
+			(unsigned long)profile_toMicros(profile_average(stats)),
+			(unsigned long)profile_toMicros(stats->max),
+			(unsigned long)(stats->max * 100ull / budget));
+
+	for(int i = 0; i < PROFILE_BUCKETS; i++)
+		printf(" %lu", (unsigned long)stats->buckets[i]);
+
+	printf("\r\n");
+}
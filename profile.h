@@ -0,0 +1,138 @@
+/**
+ * ========================
+ * File: profile.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Cycle count profiling
+ * for the audio path. Each
+ * effect and the whole block
+ * keep the min, average and
+ * max cycles they took, and a
+ * histogram of how much of the
+ * block budget that was.
+ *
+ * On the board the cycles are
+ * the DWT cycle counter, on the
+ * host the monotonic clock in
+ * cycles of SystemCoreClock.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#include "main.h"
+
+// histogram buckets, each an eighth of the block
+// budget. the last one also holds anything over
+#define PROFILE_BUCKETS 8
+
+/**
+ * @brief Times for one thing that is profiled
+ */
+typedef struct
+{
+	uint32_t count;   // times recorded
+	uint32_t min;     // cycles
+	uint32_t max;     // cycles
+	uint64_t total;   // cycles, for the average
+	uint32_t buckets[PROFILE_BUCKETS];
+}ProfileStats;
+
+/**
+ * @brief Read the cycle counter.
+ *
+ * @param None
+ *
+ * @retval Core cycles, wraps
+ */
+static inline uint32_t profile_cycles(void)
+{
+#ifdef HOST_SIM
+	return hostsim_cycles();
+#else
+	return DWT->CYCCNT;
+#endif
+}
+
+/**
+ * @brief Start the cycle counter, it is never
+ *        reset so anyone can take differences.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void profile_init(void);
+
+/**
+ * @brief Set how many cycles a block lasts,
+ *        the histogram is in eighths of this.
+ *
+ * @param cycles Cycles in one block
+ *
+ * @retval None
+ */
+void profile_setBudget(uint32_t cycles);
+
+/**
+ * @brief How many cycles a block lasts.
+ *
+ * @param None
+ *
+ * @retval Cycles in one block
+ */
+uint32_t profile_getBudget(void);
+
+/**
+ * @brief Empty a set of times.
+ *
+ * @param stats The times
+ *
+ * @retval None
+ */
+void profile_reset(ProfileStats* stats);
+
+/**
+ * @brief Record one time.
+ *
+ * @param stats The times
+ * @param cycles Cycles it took
+ *
+ * @retval None
+ */
+void profile_add(ProfileStats* stats, uint32_t cycles);
+
+/**
+ * @brief Average of a set of times.
+ *
+ * @param stats The times
+ *
+ * @retval Cycles, 0 if none recorded
+ */
+uint32_t profile_average(const ProfileStats* stats);
+
+/**
+ * @brief Convert cycles to microseconds.
+ *
+ * @param cycles Cycles
+ *
+ * @retval Microseconds
+ */
+uint32_t profile_toMicros(uint32_t cycles);
+
+/**
+ * @brief Print a set of times, min, average
+ *        and max in us and the histogram.
+ *
+ * @param name What was timed
+ * @param stats The times
+ *
+ * @retval None
+ */
+void profile_print(const char* name, const ProfileStats* stats);
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * ========================
+ * File: registry.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: The effect registry,
+ * made from the list in
+ * effectlist.h. Makes effects
+ * from a fixed pool, keeps the
+ * first of each kind for the
+ * effect windows and calls
+ * each effects kernel
+ * directly rather than
+ * through a pointer.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "registry.h"
+
+// every effect made, one after another, and how
+// many of each kind there are. the engine reads
+// them each block so they live in DTCM
+static AUDIO_DTCM Effect registry_pool[REGISTRY_POOL_SIZE];
+static int registry_poolNum;
+static int registry_kindNum[EFFECT_NUM];
+
+// first effect of each kind, indexed by EffectType
+Effect* registry_effects[EFFECT_NUM];
+
+// main window button label for each effect
+const char* const registry_labels[EFFECT_NUM] =
+{
+#define REGISTRY_LABEL(name, NAME, label) label,
+	EFFECT_LIST(REGISTRY_LABEL)
+#undef REGISTRY_LABEL
+};
+
+/**
+ * @brief Make one of every effect in the list
+ *        and fill registry_effects, call this
+ *        before using any of them. A kind that
+ *        doesn't fit its arenas is left NULL.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void registry_init(void)
+{
+	for(int i = 0; i < EFFECT_NUM; i++)
+		registry_effects[i] = registry_create((EffectType)i);
+}
+
+/**
+ * @brief Make another effect from the pool, for
+ *        a second stage of the same kind. Add it
+ *        to the routing to run it. Effects after
+ *        the first are numbered, "Delay 2".
+ *
+ * @param type Kind of effect to make
+ *
+ * @retval The effect, NULL if the pool is used up
+ *         or an arena is out of budget
+ */
+Effect* registry_create(EffectType type)
+{
+	if(registry_poolNum >= REGISTRY_POOL_SIZE)
+		return NULL;
+
+	Effect* effect = &registry_pool[registry_poolNum];
+	int result = -1;
+	ArenaMark mark;
+
+	memset(effect, 0, sizeof(Effect));
+	arena_mark(&mark);
+
+	switch(type)
+	{
+#define REGISTRY_CREATE(name, NAME, label) \
+	case EFFECT_##NAME: \
+		result = name##_create(effect); \
+		break;
+	EFFECT_LIST(REGISTRY_CREATE)
+#undef REGISTRY_CREATE
+	default:
+		break;
+	}
+
+	// give back whatever fit before the
+	// allocation that didn't
+	if(result < 0)
+	{
+		arena_rewind(&mark);
+		return NULL;
+	}
+
+	registry_poolNum++;
+
+	// number the ones after the first
+	if(++registry_kindNum[type] > 1)
+	{
+		char number[12];
+		sprintf(number, " %d", registry_kindNum[type]);
+		strncat(effect->name, number, sizeof(effect->name) - strlen(effect->name) - 1);
+	}
+
+	return effect;
+}
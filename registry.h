@@ -0,0 +1,100 @@
+/**
+ * ========================
+ * File: registry.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: The effect registry,
+ * made from the list in
+ * effectlist.h. Makes effects
+ * from a fixed pool, keeps the
+ * first of each kind for the
+ * effect windows and calls
+ * each effects kernel
+ * directly rather than
+ * through a pointer.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __REGISTRY_H
+#define __REGISTRY_H
+
+#include "main.h"
+#include "effect.h"
+#include "wahwah.h"
+#include "distortion.h"
+#include "flanger.h"
+#include "vibrato.h"
+#include "delay.h"
+#include "tremolo.h"
+
+// most effects that can be made, of any kind.
+// each one also needs room in the arenas
+#define REGISTRY_POOL_SIZE 12
+
+// first effect of each kind, indexed by EffectType,
+// NULL if it couldn't be made
+extern Effect* registry_effects[EFFECT_NUM];
+
+// main window button label for each effect
+extern const char* const registry_labels[EFFECT_NUM];
+
+/**
+ * @brief Make one of every effect in the list
+ *        and fill registry_effects, call this
+ *        before using any of them. A kind that
+ *        doesn't fit its arenas is left NULL.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void registry_init(void);
+
+/**
+ * @brief Make another effect from the pool, for
+ *        a second stage of the same kind. Add it
+ *        to the routing to run it. Effects after
+ *        the first are numbered, "Delay 2".
+ *
+ * @param type Kind of effect to make
+ *
+ * @retval The effect, NULL if the pool is used up
+ *         or an arena is out of budget
+ */
+Effect* registry_create(EffectType type);
+
+/**
+ * @brief Run an effects kernel over a block.
+ *        The switch calls each kernel by
+ *        name, so there's no indirect call
+ *        and the compiler can inline it.
+ *        Effects not in the list go through
+ *        their processBuffer pointer.
+ *
+ * @param effect The effect to run
+ * @param in Block of input frames
+ * @param out Block of output frames, can be in
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+static inline void registry_process(Effect* effect, const frame_t* in, frame_t* out, uint32_t frames)
+{
+	switch(effect->type)
+	{
+#define REGISTRY_PROCESS(name, NAME, label) \
+	case EFFECT_##NAME: \
+		name##_processBuffer(effect->state, in, out, frames); \
+		break;
+	EFFECT_LIST(REGISTRY_PROCESS)
+#undef REGISTRY_PROCESS
+	default:
+		effect->processBuffer(effect->state, in, out, frames);
+		break;
+	}
+}
+
+#endif
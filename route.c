@@ -0,0 +1,462 @@
+/**
+ * ========================
+ * File: route.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Routing graph for the
+ * effects. Effects can be run
+ * one after another, split into
+ * parallel paths and mixed back
+ * together. The graph is
+ * compiled into a list of steps
+ * that only run the effects
+ * that are on, and block buffers
+ * are reused as soon as nothing
+ * else needs them. Runs of
+ * effects that have a fused
+ * kernel can be swapped for it.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "route.h"
+#include "registry.h"
+
+/**
+ * @brief Add a node to the graph.
+ *
+ * @param graph The graph to add to
+ *
+ * @retval The new node, NULL if the graph is full
+ */
+static RouteNode* route_newNode(RouteGraph* graph)
+{
+	if(graph->nodeNum >= ROUTE_NODES_MAX)
+		return NULL;
+
+	RouteNode* node = &graph->nodes[graph->nodeNum++];
+	memset(node, 0, sizeof(RouteNode));
+	return node;
+}
+
+/**
+ * @brief Is this node an input a new node can use.
+ *
+ * @param graph The graph
+ * @param node The node
+ *
+ * @retval 1 if it is, 0 if not
+ */
+static int route_validInput(const RouteGraph* graph, int node)
+{
+	return node >= 0 && node < graph->nodeNum;
+}
+
+/**
+ * @brief Start an empty graph, it has just
+ *        the input node which goes straight
+ *        to the output.
+ *
+ * @param graph The graph to initialise
+ *
+ * @retval None
+ */
+void route_init(RouteGraph* graph)
+{
+	graph->nodeNum = 0;
+	graph->output = ROUTE_INPUT_NODE;
+
+	RouteNode* node = route_newNode(graph);
+	node->type = ROUTE_INPUT;
+}
+
+/**
+ * @brief Add an effect to the graph. An effect
+ *        should only be added once, it only
+ *        has one set of state. Make another
+ *        with registry_create() to run two.
+ *
+ * @param graph The graph to add to
+ * @param effect The effect to run
+ * @param input Node the effect takes its input from
+ *
+ * @retval The new node, -1 if it couldn't be added
+ */
+int route_addEffect(RouteGraph* graph, Effect* effect, int input)
+{
+	if(effect == NULL || !route_validInput(graph, input))
+		return -1;
+
+	RouteNode* node = route_newNode(graph);
+	if(node == NULL)
+		return -1;
+
+	node->type = ROUTE_EFFECT;
+	node->effect = effect;
+	node->input[0] = input;
+
+	return graph->nodeNum-1;
+}
+
+/**
+ * @brief Add a mix of two nodes to the graph,
+ *        this is where parallel paths merge.
+ *
+ * @param graph The graph to add to
+ * @param inputA First node to mix
+ * @param gainA Gain for the first node
+ * @param inputB Second node to mix
+ * @param gainB Gain for the second node
+ *
+ * @retval The new node, -1 if it couldn't be added
+ */
+int route_addMix(RouteGraph* graph, int inputA, float gainA, int inputB, float gainB)
+{
+	if(!route_validInput(graph, inputA) || !route_validInput(graph, inputB))
+		return -1;
+
+	RouteNode* node = route_newNode(graph);
+	if(node == NULL)
+		return -1;
+
+	node->type = ROUTE_MIX;
+	node->input[0] = inputA;
+	node->input[1] = inputB;
+	node->gain[0] = gainA;
+	node->gain[1] = gainB;
+
+	return graph->nodeNum-1;
+}
+
+/**
+ * @brief Set the node that goes to the codec.
+ *        route_add*() don't change this.
+ *
+ * @param graph The graph
+ * @param node The output node
+ *
+ * @retval None
+ */
+void route_setOutput(RouteGraph* graph, int node)
+{
+	if(route_validInput(graph, node))
+		graph->output = node;
+}
+
+/**
+ * @brief Build a graph that runs effects one
+ *        after another, in table order. NULL
+ *        entries are skipped.
+ *
+ * @param graph The graph to build
+ * @param effects Table of effects
+ * @param effectNum Number of effects in the table
+ *
+ * @retval None
+ */
+void route_serial(RouteGraph* graph, Effect** effects, int effectNum)
+{
+	int last = ROUTE_INPUT_NODE;
+
+	route_init(graph);
+
+	for(int i = 0; i < effectNum; i++)
+	{
+		// an effect that couldn't be made
+		if(effects[i] == NULL)
+			continue;
+
+		int node = route_addEffect(graph, effects[i], last);
+		if(node < 0)
+			break;
+		last = node;
+	}
+
+	route_setOutput(graph, last);
+}
+
+/**
+ * @brief Take the lowest free buffer.
+ *
+ * @param freeBuffers Bit set for each free buffer
+ *
+ * @retval Buffer number, -1 if none are free
+ */
+static int route_allocBuffer(uint32_t* freeBuffers)
+{
+	for(int i = 0; i < ROUTE_BUFFERS_MAX; i++)
+		if(*freeBuffers & (1u << i))
+		{
+			*freeBuffers &= ~(1u << i);
+			return i;
+		}
+
+	return -1;
+}
+
+/**
+ * @brief Compile a graph into the steps to run.
+ *        Effects that are off are skipped, and
+ *        a buffer is handed on as soon as its
+ *        last reader is done with it.
+ *
+ * @param graph The graph to compile
+ * @param schedule Where to put the steps
+ *
+ * @retval 0 on success, -1 if it needs more than
+ *         ROUTE_BUFFERS_MAX buffers
+ */
+int route_compile(const RouteGraph* graph, RouteSchedule* schedule)
+{
+	RouteSchedule result;
+
+	// node whose block this node passes on,
+	// an effect that is off passes on its input
+	int source[ROUTE_NODES_MAX];
+
+	// nodes that reach the output, how many steps
+	// still have to read each one, and its buffer
+	uint8_t live[ROUTE_NODES_MAX];
+	int uses[ROUTE_NODES_MAX];
+	int buffer[ROUTE_NODES_MAX];
+
+	uint32_t freeBuffers = ((1u << ROUTE_BUFFERS_MAX) - 1) & ~1u;
+
+	if(graph->nodeNum < 1 || !route_validInput(graph, graph->output))
+		return -1;
+
+	for(int n = 0; n < graph->nodeNum; n++)
+	{
+		const RouteNode* node = &graph->nodes[n];
+
+		if(node->type == ROUTE_EFFECT && !node->effect->on)
+			source[n] = source[node->input[0]];
+		else
+			source[n] = n;
+
+		live[n] = 0;
+		uses[n] = 0;
+		buffer[n] = -1;
+	}
+
+	// work back from the output to find what it needs,
+	// inputs are always earlier so one pass does it
+	live[source[graph->output]] = 1;
+	for(int n = graph->nodeNum-1; n > ROUTE_INPUT_NODE; n--)
+	{
+		const RouteNode* node = &graph->nodes[n];
+
+		if(!live[n])
+			continue;
+
+		live[source[node->input[0]]] = 1;
+		uses[source[node->input[0]]]++;
+
+		if(node->type == ROUTE_MIX)
+		{
+			live[source[node->input[1]]] = 1;
+			uses[source[node->input[1]]]++;
+		}
+	}
+
+	// the output is read after the last step
+	uses[source[graph->output]]++;
+
+	result.stepNum = 0;
+	result.effectNum = 0;
+	result.bufferNum = 1;
+	buffer[ROUTE_INPUT_NODE] = 0;
+
+	for(int n = ROUTE_INPUT_NODE+1; n < graph->nodeNum; n++)
+	{
+		const RouteNode* node = &graph->nodes[n];
+		RouteStep* step = &result.steps[result.stepNum];
+
+		if(!live[n])
+			continue;
+
+		int a = source[node->input[0]];
+		uses[a]--;
+
+		step->type = node->type;
+		step->effect = node->effect;
+		step->input[0] = buffer[a];
+
+		if(node->type == ROUTE_MIX)
+		{
+			int b = source[node->input[1]];
+			uses[b]--;
+
+			step->input[1] = buffer[b];
+#if AUDIO_FIXED_POINT
+			step->gain[0] = dsp_float_to_q15(node->gain[0]);
+			step->gain[1] = dsp_float_to_q15(node->gain[1]);
+#else
+			step->gain[0] = node->gain[0];
+			step->gain[1] = node->gain[1];
+#endif
+
+			// write over whichever input is finished with,
+			// hand the other one back if it's done too
+			if(uses[a] == 0)
+			{
+				buffer[n] = buffer[a];
+				if(b != a && uses[b] == 0)
+					freeBuffers |= 1u << buffer[b];
+			}
+			else if(uses[b] == 0)
+				buffer[n] = buffer[b];
+			else
+				buffer[n] = route_allocBuffer(&freeBuffers);
+		}
+		else
+		{
+			// last reader works in place
+			if(uses[a] == 0)
+				buffer[n] = buffer[a];
+			else
+				buffer[n] = route_allocBuffer(&freeBuffers);
+		}
+
+		if(buffer[n] < 0)
+			return -1;
+
+		if(buffer[n]+1 > result.bufferNum)
+			result.bufferNum = buffer[n]+1;
+
+		step->output = buffer[n];
+		result.stepNum++;
+
+		if(node->type == ROUTE_EFFECT)
+			result.effects[result.effectNum++] = node->effect;
+	}
+
+	result.output = buffer[source[graph->output]];
+
+	*schedule = result;
+	return 0;
+}
+
+/**
+ * @brief Swap runs of effects in a compiled graph
+ *        for fused kernels, where there is one.
+ *        A run is effects one after another, each
+ *        working in place on the one before.
+ *
+ * @param schedule The compiled graph
+ *
+ * @retval None
+ */
+void route_fuse(RouteSchedule* schedule)
+{
+	int stepNum = 0;
+
+	for(int i = 0; i < schedule->stepNum;)
+	{
+		RouteStep step = schedule->steps[i];
+		Effect* run[FUSED_STAGES_MAX];
+		int runNum = 0;
+
+		// effects that can fuse, the ones after the first
+		// must be the only reader of the last ones output
+		if(step.type == ROUTE_EFFECT && fused_canFuse(step.effect))
+		{
+			run[runNum++] = step.effect;
+
+			while(runNum < FUSED_STAGES_MAX && i+runNum < schedule->stepNum)
+			{
+				const RouteStep* next = &schedule->steps[i+runNum];
+
+				if(next->type != ROUTE_EFFECT || !fused_canFuse(next->effect))
+					break;
+				if(next->input[0] != step.output || next->output != step.output)
+					break;
+
+				run[runNum++] = next->effect;
+			}
+		}
+
+		// longest start of the run that has a kernel
+		FusedKernel kernel = FUSED_NONE;
+		while(runNum > 1 && (kernel = fused_find(run, runNum)) == FUSED_NONE)
+			runNum--;
+
+		if(kernel != FUSED_NONE)
+		{
+			step.type = ROUTE_FUSED;
+			step.kernel = kernel;
+			for(int j = 0; j < runNum; j++)
+				step.fused[j] = run[j];
+			step.fusedNum = runNum;
+			i += runNum;
+		}
+		else
+			i++;
+
+		// steps only ever get fewer, so this
+		// never writes over one still to read
+		schedule->steps[stepNum++] = step;
+	}
+
+	schedule->stepNum = stepNum;
+}
+
+/**
+ * @brief Run a compiled graph over a block,
+ *        timing each effect into its profile.
+ *
+ * @param schedule The compiled graph
+ * @param buffers ROUTE_BUFFERS_MAX block buffers,
+ *        the input block is in buffers[0]
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+AUDIO_ITCM void route_run(const RouteSchedule* schedule, frame_t** buffers, uint32_t frames)
+{
+	for(int i = 0; i < schedule->stepNum; i++)
+	{
+		const RouteStep* step = &schedule->steps[i];
+		frame_t* in  = buffers[step->input[0]];
+		frame_t* out = buffers[step->output];
+
+		if(step->type == ROUTE_EFFECT)
+		{
+			uint32_t start = profile_cycles();
+			registry_process(step->effect, in, out, frames);
+			profile_add(&step->effect->profile, profile_cycles() - start);
+			continue;
+		}
+
+		if(step->type == ROUTE_FUSED)
+		{
+			uint32_t start = profile_cycles();
+			fused_run(step->kernel, step->fused, in, out, frames);
+
+			// one pass runs them all, so they
+			// share what it took evenly
+			uint32_t share = (profile_cycles() - start) / step->fusedNum;
+			for(int j = 0; j < step->fusedNum; j++)
+				profile_add(&step->fused[j]->profile, share);
+			continue;
+		}
+
+		// mix, out may be either input
+		frame_t* in2 = buffers[step->input[1]];
+#if AUDIO_FIXED_POINT
+		frame_t gainA = dsp_pack(step->gain[0], step->gain[0]);
+		frame_t gainB = dsp_pack(step->gain[1], step->gain[1]);
+#endif
+		for(uint32_t j = 0; j < frames; j++)
+		{
+#if AUDIO_FIXED_POINT
+			out[j] = dsp_add2(dsp_mul2(in[j], gainA), dsp_mul2(in2[j], gainB));
+#else
+			out[j].l = in[j].l*step->gain[0] + in2[j].l*step->gain[1];
+			out[j].r = in[j].r*step->gain[0] + in2[j].r*step->gain[1];
+#endif
+		}
+	}
+}
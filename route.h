@@ -0,0 +1,211 @@
+/**
+ * ========================
+ * File: route.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Routing graph for the
+ * effects. Effects can be run
+ * one after another, split into
+ * parallel paths and mixed back
+ * together. The graph is
+ * compiled into a list of steps
+ * that only run the effects
+ * that are on, and block buffers
+ * are reused as soon as nothing
+ * else needs them. Runs of
+ * effects that have a fused
+ * kernel can be swapped for it.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __ROUTE_H
+#define __ROUTE_H
+
+#include "main.h"
+#include "effect.h"
+#include "fused.h"
+
+// most nodes in a graph, and most block
+// buffers a compiled graph can use
+#define ROUTE_NODES_MAX   16
+#define ROUTE_BUFFERS_MAX 4
+
+// the input node is always node 0
+#define ROUTE_INPUT_NODE  0
+
+/**
+ * @brief What a node in the graph does
+ */
+typedef enum
+{
+	ROUTE_INPUT = 0, // the block from the codec
+	ROUTE_EFFECT,    // runs an effect on its input
+	ROUTE_MIX,       // adds two inputs together
+	ROUTE_FUSED,     // steps only, runs a fused kernel
+}RouteNodeType;
+
+/**
+ * @brief A node in the routing graph.
+ *        Nodes can only take input from
+ *        nodes added before them, a node
+ *        used by more than one node is a
+ *        split.
+ */
+typedef struct
+{
+	RouteNodeType type;
+	Effect* effect;   // ROUTE_EFFECT only
+	int input[2];     // input[1] is ROUTE_MIX only
+	float gain[2];    // ROUTE_MIX only
+}RouteNode;
+
+/**
+ * @brief A routing graph, build one with
+ *        route_init() and route_add*()
+ */
+typedef struct
+{
+	RouteNode nodes[ROUTE_NODES_MAX];
+	int nodeNum;
+	int output;       // node that goes to the codec
+}RouteGraph;
+
+/**
+ * @brief One step of a compiled graph,
+ *        in and out are buffer numbers
+ */
+typedef struct
+{
+	RouteNodeType type;
+	Effect* effect;
+	uint8_t input[2];
+	uint8_t output;
+	sample_t gain[2];
+	FusedKernel kernel;                 // ROUTE_FUSED only
+	Effect* fused[FUSED_STAGES_MAX];    // ROUTE_FUSED only
+	uint8_t fusedNum;                   // ROUTE_FUSED only
+}RouteStep;
+
+/**
+ * @brief A compiled graph. The block to
+ *        process goes in buffer 0, the
+ *        result ends up in buffer output.
+ */
+typedef struct
+{
+	RouteStep steps[ROUTE_NODES_MAX];
+	int stepNum;
+	uint8_t output;
+	uint8_t bufferNum; // buffers this schedule needs
+
+	// every effect the steps run
+	Effect* effects[ROUTE_NODES_MAX];
+	int effectNum;
+}RouteSchedule;
+
+/**
+ * @brief Start an empty graph, it has just
+ *        the input node which goes straight
+ *        to the output.
+ *
+ * @param graph The graph to initialise
+ *
+ * @retval None
+ */
+void route_init(RouteGraph* graph);
+
+/**
+ * @brief Add an effect to the graph. An effect
+ *        should only be added once, it only
+ *        has one set of state. Make another
+ *        with registry_create() to run two.
+ *
+ * @param graph The graph to add to
+ * @param effect The effect to run
+ * @param input Node the effect takes its input from
+ *
+ * @retval The new node, -1 if it couldn't be added
+ */
+int route_addEffect(RouteGraph* graph, Effect* effect, int input);
+
+/**
+ * @brief Add a mix of two nodes to the graph,
+ *        this is where parallel paths merge.
+ *
+ * @param graph The graph to add to
+ * @param inputA First node to mix
+ * @param gainA Gain for the first node
+ * @param inputB Second node to mix
+ * @param gainB Gain for the second node
+ *
+ * @retval The new node, -1 if it couldn't be added
+ */
+int route_addMix(RouteGraph* graph, int inputA, float gainA, int inputB, float gainB);
+
+/**
+ * @brief Set the node that goes to the codec.
+ *        route_add*() don't change this.
+ *
+ * @param graph The graph
+ * @param node The output node
+ *
+ * @retval None
+ */
+void route_setOutput(RouteGraph* graph, int node);
+
+/**
+ * @brief Build a graph that runs effects one
+ *        after another, in table order. NULL
+ *        entries are skipped.
+ *
+ * @param graph The graph to build
+ * @param effects Table of effects
+ * @param effectNum Number of effects in the table
+ *
+ * @retval None
+ */
+void route_serial(RouteGraph* graph, Effect** effects, int effectNum);
+
+/**
+ * @brief Compile a graph into the steps to run.
+ *        Effects that are off are skipped, and
+ *        a buffer is handed on as soon as its
+ *        last reader is done with it.
+ *
+ * @param graph The graph to compile
+ * @param schedule Where to put the steps
+ *
+ * @retval 0 on success, -1 if it needs more than
+ *         ROUTE_BUFFERS_MAX buffers
+ */
+int route_compile(const RouteGraph* graph, RouteSchedule* schedule);
+
+/**
+ * @brief Swap runs of effects in a compiled graph
+ *        for fused kernels, where there is one.
+ *        A run is effects one after another, each
+ *        working in place on the one before.
+ *
+ * @param schedule The compiled graph
+ *
+ * @retval None
+ */
+void route_fuse(RouteSchedule* schedule);
+
+/**
+ * @brief Run a compiled graph over a block,
+ *        timing each effect into its profile.
+ *
+ * @param schedule The compiled graph
+ * @param buffers ROUTE_BUFFERS_MAX block buffers,
+ *        the input block is in buffers[0]
+ * @param frames Number of frames in the block
+ *
+ * @retval None
+ */
+void route_run(const RouteSchedule* schedule, frame_t** buffers, uint32_t frames);
+
+#endif
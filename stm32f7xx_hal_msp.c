@@ -9,11 +9,12 @@
  *       These functions are used internally by the HAL library 
  *       provided by STMicroelectronics.
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
 #include "main.h"
+#include "tasks.h"
 
 /**
  * @brief Initializes the Global MSP.
@@ -42,8 +43,9 @@ void HAL_MspInit(void)
   // DebugMonitor_IRQn interrupt configuration
   HAL_NVIC_SetPriority(DebugMonitor_IRQn, 3, 0);
 
-  // PendSV_IRQn interrupt configuration
-  HAL_NVIC_SetPriority(PendSV_IRQn, 3, 0);
+  // PendSV_IRQn interrupt configuration, runs the
+  // audio task under the audio DMA interrupts
+  HAL_NVIC_SetPriority(PendSV_IRQn, TASK_IRQ_PRIORITY_AUDIO, 0);
 }
 
 /**
@@ -61,8 +63,8 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
     // Peripheral clock enable
     __HAL_RCC_TIM10_CLK_ENABLE();
 
-    // TIM10 interrupt Init
-    HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn, 0, 0);
+    // TIM10 interrupt Init, under the audio DMA
+    HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn, TASK_IRQ_PRIORITY_TICK, 0);
     HAL_NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
   }
 }
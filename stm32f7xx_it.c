@@ -7,12 +7,13 @@
  * Desc: Implementations for interrupt
  * routines used in our application.
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
 #include "main.h"
 #include "stm32f7xx_it.h"
+#include "tasks.h"
 
 // TypeDef Handles for any periphials we used.
 extern TIM_HandleTypeDef htim10;
@@ -94,7 +95,8 @@ void DebugMon_Handler(void)
   */
 void PendSV_Handler(void)
 {
-
+	// the audio task
+	task_pendSV();
 }
 
 /**
@@ -114,6 +114,9 @@ int _write(int file, char *ptr, int len)
 caddr_t _sbrk(int incr)
 {
 	extern char end asm("end");
+	// the stack is in DTCM, below the heap,
+	// so the heap can run to the end of RAM
+	extern char _eheap asm("_eheap");
 	static char *heap_end;
 	char *prev_heap_end;
 
@@ -121,7 +124,7 @@ caddr_t _sbrk(int incr)
 		heap_end = &end;
 
 	prev_heap_end = heap_end;
-	if (heap_end + incr > stack_ptr)
+	if (heap_end + incr > &_eheap)
 	{
 //		write(1, "Heap and stack collision\n", 25);
 //		abort();
@@ -0,0 +1,404 @@
+/**
+ * ========================
+ * File: tasks.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: A small task scheduler.
+ * Tasks are functions that run
+ * to completion, one per
+ * priority. Interrupts and other
+ * tasks signal a task to run, or
+ * send it a message through a
+ * bounded queue.
+ *
+ * The audio task runs from PendSV
+ * so it breaks into any other
+ * task as soon as the DMA
+ * interrupt that woke it
+ * returns. The rest take turns
+ * from the main loop, highest
+ * priority first, so LCD drawing
+ * or file I/O can slow each other
+ * down but never a block.
+ *
+ * On the host each task is a
+ * thread, so the same task code
+ * can be run and stress tested
+ * on Linux.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "tasks.h"
+
+#ifdef HOST_SIM
+#include <pthread.h>
+#endif
+
+/**
+ * @brief A task and what it runs
+ */
+typedef struct
+{
+	TaskFunc run;
+	void* arg;
+}TaskSlot;
+
+static TaskSlot tasks[TASK_NUM];
+
+// a bit for each task that has been
+// signalled and hasn't run since
+static volatile uint32_t ready;
+
+#ifdef HOST_SIM
+// task threads sleep on this until signalled, they
+// keep their own copy of the ready bits so they never
+// hold wake_lock and the interrupt lock together
+static pthread_t threads[TASK_NUM];
+static pthread_mutex_t wake_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static uint32_t woken;
+static int stopping;
+
+// held while the audio task runs, and by
+// task_lockAudio() to keep it off
+static pthread_mutex_t audio_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * @brief Set what a task runs. Set the audio
+ *        task before the streams start.
+ *
+ * @param task The task
+ * @param run Function to run, NULL for none
+ * @param arg Passed to run
+ *
+ * @retval None
+ */
+void task_set(TaskId task, TaskFunc run, void* arg)
+{
+	tasks[task].arg = arg;
+	tasks[task].run = run;
+}
+
+/**
+ * @brief Mark a task as ready to run, safe
+ *        to call from an interrupt.
+ *
+ * @param task The task
+ *
+ * @retval None
+ */
+AUDIO_ITCM void task_signal(TaskId task)
+{
+	__disable_irq();
+	ready |= 1u << task;
+	__enable_irq();
+
+#ifdef HOST_SIM
+	pthread_mutex_lock(&wake_lock);
+	woken |= 1u << task;
+	pthread_cond_broadcast(&wake);
+	pthread_mutex_unlock(&wake_lock);
+#else
+	// PendSV runs the audio task once
+	// the interrupts above it are done
+	if(task == TASK_AUDIO)
+		SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+}
+
+/**
+ * @brief Clear a tasks ready bit if it's set.
+ *
+ * @param task The task
+ *
+ * @retval 1 if it was ready, 0 if not
+ */
+static AUDIO_ITCM int task_take(TaskId task)
+{
+	int taken;
+
+	__disable_irq();
+	taken = (ready >> task) & 1;
+	ready &= ~(1u << task);
+	__enable_irq();
+
+	return taken;
+}
+
+/**
+ * @brief Run a task if it's ready.
+ *
+ * @param task The task
+ *
+ * @retval 1 if it ran, 0 if not
+ */
+static AUDIO_ITCM int task_run(TaskId task)
+{
+	if(!task_take(task))
+		return 0;
+
+	if(tasks[task].run)
+		tasks[task].run(tasks[task].arg);
+
+	return 1;
+}
+
+/**
+ * @brief Run the audio task, called from
+ *        PendSV_Handler().
+ *
+ * @param None
+ *
+ * @retval None
+ */
+AUDIO_ITCM void task_pendSV(void)
+{
+	// signalled again while it ran, go again
+	while(task_run(TASK_AUDIO))
+		;
+}
+
+#ifdef HOST_SIM
+/**
+ * @brief Thread for one task, waits to be
+ *        signalled and runs it.
+ *
+ * @param arg The task
+ *
+ * @retval NULL
+ */
+static void* task_thread(void* arg)
+{
+	TaskId task = (TaskId)(intptr_t)arg;
+
+	while(1)
+	{
+		pthread_mutex_lock(&wake_lock);
+		while(!((woken >> task) & 1) && !stopping)
+			pthread_cond_wait(&wake, &wake_lock);
+		woken &= ~(1u << task);
+		int stop = stopping;
+		pthread_mutex_unlock(&wake_lock);
+
+		if(stop)
+			break;
+
+		if(task == TASK_AUDIO)
+			pthread_mutex_lock(&audio_lock);
+		task_run(task);
+		if(task == TASK_AUDIO)
+			pthread_mutex_unlock(&audio_lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Start a thread for each task. They
+ *        get real time priorities in task
+ *        order if Linux lets us, if not they
+ *        just run at normal priority.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_start(void)
+{
+	stopping = 0;
+
+	for(int task = 0; task < TASK_NUM; task++)
+	{
+		pthread_attr_t attr;
+		struct sched_param param;
+
+		pthread_attr_init(&attr);
+		pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+		pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+		param.sched_priority = sched_get_priority_max(SCHED_FIFO) - task;
+		pthread_attr_setschedparam(&attr, &param);
+
+		if(pthread_create(&threads[task], &attr, task_thread, (void*)(intptr_t)task) != 0)
+			pthread_create(&threads[task], NULL, task_thread, (void*)(intptr_t)task);
+
+		pthread_attr_destroy(&attr);
+	}
+}
+
+/**
+ * @brief Stop the task threads and wait
+ *        for them to finish, host only.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_stop(void)
+{
+	pthread_mutex_lock(&wake_lock);
+	stopping = 1;
+	pthread_cond_broadcast(&wake);
+	pthread_mutex_unlock(&wake_lock);
+
+	for(int task = 0; task < TASK_NUM; task++)
+		pthread_join(threads[task], NULL);
+}
+#else
+/**
+ * @brief Run the tasks. The audio task runs
+ *        from PendSV, the rest from here
+ *        highest priority first, and the core
+ *        sleeps when none are ready. Never
+ *        returns.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_start(void)
+{
+	// PendSV priority is set in HAL_MspInit()
+	while(1)
+	{
+		// one task at a time, then look again
+		// in case something higher came in
+		int ran = 0;
+		for(int task = TASK_AUDIO+1; task < TASK_NUM && !ran; task++)
+			ran = task_run(task);
+
+		if(ran)
+			continue;
+
+		// irqs masked so a signal can't land between
+		// the check and the WFI, a pending irq still
+		// wakes the core and runs once we unmask
+		__disable_irq();
+		if(!(ready & ~(1u << TASK_AUDIO)))
+			__WFI();
+		__enable_irq();
+	}
+}
+#endif
+
+/**
+ * @brief Hold off the audio task, the DMA
+ *        interrupts still run. For the short
+ *        bits of another task that can't share
+ *        with it, like a touch read on the I2C
+ *        bus the codec is on. Don't nest it.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_lockAudio(void)
+{
+#ifdef HOST_SIM
+	pthread_mutex_lock(&audio_lock);
+#else
+	// masks PendSV and anything at its priority
+	__set_BASEPRI(TASK_IRQ_PRIORITY_AUDIO << (8 - __NVIC_PRIO_BITS));
+	__ISB();
+#endif
+}
+
+/**
+ * @brief Let the audio task run again, it
+ *        runs straight away if it was
+ *        signalled while locked.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_unlockAudio(void)
+{
+#ifdef HOST_SIM
+	pthread_mutex_unlock(&audio_lock);
+#else
+	__set_BASEPRI(0);
+	__ISB();
+#endif
+}
+
+/**
+ * @brief Set up an empty queue.
+ *
+ * @param queue The queue
+ * @param storage size items of itemSize bytes
+ * @param itemSize Size of a message
+ * @param size Most messages it holds
+ * @param task Task to signal when one is sent
+ *
+ * @retval None
+ */
+void task_queueInit(TaskQueue* queue, void* storage, uint16_t itemSize, uint16_t size, TaskId task)
+{
+	queue->items = storage;
+	queue->itemSize = itemSize;
+	queue->size = size;
+	queue->head = 0;
+	queue->count = 0;
+	queue->task = task;
+	queue->dropped = 0;
+}
+
+/**
+ * @brief Send a message and signal the queues
+ *        task, safe to call from an interrupt.
+ *
+ * @param queue The queue
+ * @param item Message to copy in
+ *
+ * @retval 0 on success, -1 if the queue was full
+ */
+int task_send(TaskQueue* queue, const void* item)
+{
+	__disable_irq();
+
+	if(queue->count >= queue->size)
+	{
+		queue->dropped++;
+		__enable_irq();
+		return -1;
+	}
+
+	uint16_t tail = (queue->head + queue->count) % queue->size;
+	memcpy(queue->items + tail*queue->itemSize, item, queue->itemSize);
+	queue->count++;
+
+	__enable_irq();
+
+	task_signal(queue->task);
+	return 0;
+}
+
+/**
+ * @brief Take the oldest message.
+ *
+ * @param queue The queue
+ * @param item Where to copy it
+ *
+ * @retval 1 if there was one, 0 if empty
+ */
+int task_receive(TaskQueue* queue, void* item)
+{
+	__disable_irq();
+
+	if(queue->count == 0)
+	{
+		__enable_irq();
+		return 0;
+	}
+
+	memcpy(item, queue->items + queue->head*queue->itemSize, queue->itemSize);
+	queue->head = (queue->head + 1) % queue->size;
+	queue->count--;
+
+	__enable_irq();
+	return 1;
+}
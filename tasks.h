@@ -0,0 +1,199 @@
+/**
+ * ========================
+ * File: tasks.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: A small task scheduler.
+ * Tasks are functions that run
+ * to completion, one per
+ * priority. Interrupts and other
+ * tasks signal a task to run, or
+ * send it a message through a
+ * bounded queue.
+ *
+ * The audio task runs from PendSV
+ * so it breaks into any other
+ * task as soon as the DMA
+ * interrupt that woke it
+ * returns. The rest take turns
+ * from the main loop, highest
+ * priority first, so LCD drawing
+ * or file I/O can slow each other
+ * down but never a block.
+ *
+ * On the host each task is a
+ * thread, so the same task code
+ * can be run and stress tested
+ * on Linux.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __TASKS_H
+#define __TASKS_H
+
+#include "main.h"
+
+/**
+ * @brief The tasks, highest priority first
+ */
+typedef enum
+{
+	TASK_AUDIO = 0, // processes blocks, from PendSV
+	TASK_UI,        // touch and drawing
+	TASK_STORAGE,   // file I/O
+	TASK_TELEMETRY, // stats out over the UART
+	TASK_NUM
+}TaskId;
+
+// NVIC priorities the scheduler relies on, 0 is the
+// highest. the audio DMA interrupts have to be able
+// to break into the audio task so it can tell when
+// it's late
+#define TASK_IRQ_PRIORITY_DMA   14
+#define TASK_IRQ_PRIORITY_AUDIO 15
+
+// the UI timer only signals the UI task, so
+// it sits under the audio DMA with PendSV
+#define TASK_IRQ_PRIORITY_TICK  15
+
+/**
+ * @brief What a task runs each time it's
+ *        signalled, it should return
+ *        once it's done its work
+ */
+typedef void (*TaskFunc)(void* arg);
+
+/**
+ * @brief A bounded queue of fixed size
+ *        messages. Sending to a full queue
+ *        drops the message and counts it.
+ */
+typedef struct
+{
+	uint8_t* items;
+	uint16_t itemSize;
+	uint16_t size;          // most messages it holds
+	volatile uint16_t head; // next to receive
+	volatile uint16_t count;
+	TaskId task;         // signalled on each send
+	volatile uint32_t dropped;
+}TaskQueue;
+
+/**
+ * @brief Set what a task runs. Set the audio
+ *        task before the streams start.
+ *
+ * @param task The task
+ * @param run Function to run, NULL for none
+ * @param arg Passed to run
+ *
+ * @retval None
+ */
+void task_set(TaskId task, TaskFunc run, void* arg);
+
+/**
+ * @brief Mark a task as ready to run, safe
+ *        to call from an interrupt.
+ *
+ * @param task The task
+ *
+ * @retval None
+ */
+void task_signal(TaskId task);
+
+/**
+ * @brief Run the tasks. On the board this is
+ *        the main loop and never returns, on
+ *        the host it starts a thread for each
+ *        task and returns.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_start(void);
+
+/**
+ * @brief Run the audio task, called from
+ *        PendSV_Handler().
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_pendSV(void);
+
+/**
+ * @brief Hold off the audio task, the DMA
+ *        interrupts still run. For the short
+ *        bits of another task that can't share
+ *        with it, like a touch read on the I2C
+ *        bus the codec is on. Don't nest it.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_lockAudio(void);
+
+/**
+ * @brief Let the audio task run again, it
+ *        runs straight away if it was
+ *        signalled while locked.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_unlockAudio(void);
+
+#ifdef HOST_SIM
+/**
+ * @brief Stop the task threads and wait
+ *        for them to finish, host only.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void task_stop(void);
+#endif
+
+/**
+ * @brief Set up an empty queue.
+ *
+ * @param queue The queue
+ * @param storage size items of itemSize bytes
+ * @param itemSize Size of a message
+ * @param size Most messages it holds
+ * @param task Task to signal when one is sent
+ *
+ * @retval None
+ */
+void task_queueInit(TaskQueue* queue, void* storage, uint16_t itemSize, uint16_t size, TaskId task);
+
+/**
+ * @brief Send a message and signal the queues
+ *        task, safe to call from an interrupt.
+ *
+ * @param queue The queue
+ * @param item Message to copy in
+ *
+ * @retval 0 on success, -1 if the queue was full
+ */
+int task_send(TaskQueue* queue, const void* item);
+
+/**
+ * @brief Take the oldest message.
+ *
+ * @param queue The queue
+ * @param item Where to copy it
+ *
+ * @retval 1 if there was one, 0 if empty
+ */
+int task_receive(TaskQueue* queue, void* item);
+
+#endif
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""
+========================
+File: check_map.py
+
+Author: Joseph Kenyon
+
+Desc: Checks the linker map
+that the audio hot path ended
+up where it should. Every
+function marked AUDIO_ITCM must
+be in ITCM, everything marked
+AUDIO_DTCM in DTCM, and the
+stack at the top of DTCM.
+Prints how full each TCM is.
+
+Run it as a post-build step:
+  python3 tools/check_map.py GuitarEffectsPedal.map
+
+Exits 1 if anything is in the
+wrong place.
+
+Last Updated: 16/10/2026
+
+========================
+"""
+import os
+import re
+import sys
+
+# section each marker puts things in, and the memory it must land in
+PLACEMENT = {
+    "AUDIO_ITCM": (".itcm_text", "ITCMRAM"),
+    "AUDIO_DTCM": (".dtcm_bss", "DTCMRAM"),
+}
+
+HEX = r"0x[0-9a-fA-F]+"
+
+
+def read_memories(lines):
+    """Memory Configuration table, name -> (origin, length)"""
+    memories = {}
+    inside = False
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            inside = True
+            continue
+        if inside and line.startswith("Linker script and memory map"):
+            break
+        m = re.match(r"^(\w+)\s+(" + HEX + r")\s+(" + HEX + r")", line)
+        if inside and m:
+            memories[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+    return memories
+
+
+def read_sections(lines):
+    """input sections as (name, address, size, object), and
+    global symbols as name -> address"""
+    sections = []
+    symbols = {}
+    i = 0
+    while i < len(lines):
+        line = lines[i].rstrip("\n")
+
+        # long section names wrap onto the next line
+        if re.match(r"^ \S+$", line) and i+1 < len(lines) and re.match(r"^\s+" + HEX, lines[i+1]):
+            line = line + lines[i+1].rstrip("\n")
+            i += 1
+
+        m = re.match(r"^ (\.\S+)\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S+)", line)
+        if m:
+            sections.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+        else:
+            m = re.match(r"^\s+(" + HEX + r")\s+([A-Za-z_]\w*)\s*($| = )", line)
+            if m:
+                symbols[m.group(2)] = int(m.group(1), 16)
+        i += 1
+    return sections, symbols
+
+
+def read_markers(src):
+    """functions and variables marked in the source, as
+    marker -> [(object, name, static)]"""
+    marked = {marker: [] for marker in PLACEMENT}
+    pattern = re.compile(r"^(static\s+)?(AUDIO_ITCM|AUDIO_DTCM)\s+[^(;=\[]*?\b(\w+)\s*[(\[;=]", re.M)
+    for file in sorted(os.listdir(src)):
+        if not file.endswith(".c"):
+            continue
+        with open(os.path.join(src, file), encoding="latin-1") as f:
+            text = f.read()
+        for m in pattern.finditer(text):
+            marked[m.group(2)].append((file[:-2] + ".o", m.group(3), bool(m.group(1))))
+    return marked
+
+
+def within(memories, memory, address):
+    origin, length = memories[memory]
+    return origin <= address < origin + length
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: check_map.py <map file> [source dir]")
+        return 2
+
+    src = sys.argv[2] if len(sys.argv) > 2 else os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+    with open(sys.argv[1], encoding="latin-1") as f:
+        lines = f.readlines()
+
+    memories = read_memories(lines)
+    sections, symbols = read_sections(lines)
+    marked = read_markers(src)
+    errors = []
+
+    for marker, (section, memory) in PLACEMENT.items():
+        if memory not in memories:
+            errors.append("no %s in the memory map, wrong linker script?" % memory)
+            continue
+
+        # every input section of this name has to be in the memory
+        used = 0
+        objects = set()
+        for name, address, size, obj in sections:
+            if not name.startswith(section) or size == 0:
+                continue
+            if not within(memories, memory, address):
+                errors.append("%s from %s is at 0x%08x, not in %s" % (name, obj, address, memory))
+            used += size
+            objects.add(os.path.basename(obj))
+
+        # globals can be checked by name, statics only
+        # by their object having put something there
+        for obj, name, static in marked[marker]:
+            if not static and name in symbols:
+                if not within(memories, memory, symbols[name]):
+                    errors.append("%s is at 0x%08x, not in %s" % (name, symbols[name], memory))
+            elif obj not in objects:
+                errors.append("%s in %s is %s but %s has nothing in %s" % (name, obj, marker, obj, section))
+
+        origin, length = memories[memory]
+        print("%-8s %7d / %7d bytes %3d%%" % (memory, used, length, used * 100 // length))
+
+    if "_estack" in symbols and "DTCMRAM" in memories:
+        origin, length = memories["DTCMRAM"]
+        if symbols["_estack"] != origin + length:
+            errors.append("stack isn't at the top of DTCMRAM")
+
+    for error in errors:
+        print("error: " + error)
+
+    if errors:
+        return 1
+
+    print("placement ok")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
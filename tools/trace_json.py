@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+========================
+File: trace_json.py
+
+Author: Joseph Kenyon
+
+Desc: Turns a trace dump from
+trace_dump() into Chrome trace
+JSON, which chrome://tracing and
+ui.perfetto.dev both open. The
+dump can be a UART capture or
+host output, anything outside
+the dump is skipped. The event
+names, tracks and clock come
+from the dump itself.
+
+  python3 tools/trace_json.py uart.log > trace.json
+
+Last Updated: 16/10/2026
+
+========================
+"""
+import json
+import re
+import sys
+
+RECORD = re.compile(r"^([0-9a-fA-F]{8}) ([0-9a-fA-F]{2}) ([0-9a-fA-F]{4})$")
+
+
+def read_dump(lines):
+    """each dump in the lines as a dict of clock, events, records
+    and lost. events is id -> (kind, track, name) and records
+    are (cycles, event, arg) oldest first"""
+    dump = None
+    for line in lines:
+        line = line.strip()
+        if line == "trace begin":
+            dump = {"clock": 0, "events": {}, "records": [], "lost": 0}
+        elif dump is None:
+            continue
+        elif line.startswith("clock "):
+            dump["clock"] = int(line.split()[1])
+        elif line.startswith("event "):
+            _, number, kind, rest = line.split(" ", 3)
+            track, name = rest.split("|", 1)
+            dump["events"][int(number)] = (kind, track, name)
+        elif line.startswith("trace end"):
+            dump["lost"] = int(line.split()[2])
+            done = dump
+            dump = None
+            yield done
+        else:
+            m = RECORD.match(line)
+            if m:
+                dump["records"].append((int(m.group(1), 16), int(m.group(2), 16), int(m.group(3), 16)))
+
+
+def convert(dump):
+    """Chrome trace events for a dump, times in us from the first record"""
+    clock = dump["clock"]
+    tracks = {}
+    depth = {}
+    events = []
+
+    # the counter wraps, it's only ever read going forwards
+    start = None
+    last = 0
+    wraps = 0
+
+    for cycles, number, arg in dump["records"]:
+        if start is not None and cycles < last:
+            wraps += 1
+        last = cycles
+        cycles += wraps << 32
+        if start is None:
+            start = cycles
+
+        kind, track, name = dump["events"].get(number, ("i", "unknown", "event %d" % number))
+        tid = tracks.setdefault(track, len(tracks) + 1)
+
+        # the ring can start part way through a span
+        if kind == "E" and depth.get(tid, 0) == 0:
+            continue
+        if kind in "BE":
+            depth[tid] = depth.get(tid, 0) + (1 if kind == "B" else -1)
+
+        event = {
+            "name": name,
+            "ph": kind,
+            "ts": (cycles - start) * 1e6 / clock,
+            "pid": 1,
+            "tid": tid,
+            "args": {"arg": arg},
+        }
+        if kind == "i":
+            event["s"] = "t"
+        events.append(event)
+
+    # name the tracks
+    for track, tid in tracks.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": track}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ms", "otherData": {"clock": clock, "lost": dump["lost"]}}
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: trace_json.py <dump file>")
+        return 2
+
+    with open(sys.argv[1], encoding="latin-1") as f:
+        dumps = list(read_dump(f))
+
+    if not dumps:
+        print("no trace dump in %s" % sys.argv[1], file=sys.stderr)
+        return 1
+
+    json.dump(convert(dumps[-1]), sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,182 @@
+/**
+ * ========================
+ * File: trace.c
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Trace ring for glitch
+ * hunting. Blocks, DMA
+ * interrupts, UI ticks, touches,
+ * LCD draws and codec writes
+ * each put a record with a cycle
+ * time in a ring in DTCM, and
+ * the oldest are written over.
+ * A dump prints the ring as text
+ * over the UART, or to stdout on
+ * the host, and
+ * tools/trace_json.py turns that
+ * into Chrome/Perfetto trace JSON.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#include "trace.h"
+#include "tasks.h"
+
+/**
+ * @brief How to show an event
+ */
+typedef struct
+{
+	const char* name;
+	TraceKind kind;
+	const char* track;
+}TraceInfo;
+
+static const TraceInfo trace_info[TRACE_EVENT_NUM] =
+{
+#define TRACE_EVENT_INFO(NAME, name, kind, track) { name, kind, track },
+	TRACE_LIST(TRACE_EVENT_INFO)
+#undef TRACE_EVENT_INFO
+};
+
+static const char trace_kinds[] = { 'B', 'E', 'i' };
+
+// the ring, and how many records have ever
+// been put in it. the newest is at head-1
+static TraceRecord* ring;
+static uint32_t head;
+
+static volatile uint8_t enabled;
+static volatile uint8_t dump_requested;
+
+/**
+ * @brief Take the ring from DTCM and start
+ *        tracing. Nothing is recorded until
+ *        this is called.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_init(void)
+{
+	ring = arena_alloc(ARENA_DTCM, TRACE_SIZE*sizeof(TraceRecord), ARENA_ALIGN);
+	head = 0;
+	dump_requested = 0;
+	trace_setEnabled(1);
+}
+
+/**
+ * @brief Record an event, safe to call
+ *        from an interrupt.
+ *
+ * @param event The event
+ * @param arg Anything to go with it
+ *
+ * @retval None
+ */
+AUDIO_ITCM void trace_event(TraceEvent event, uint16_t arg)
+{
+	__disable_irq();
+
+	if(enabled)
+	{
+		TraceRecord* record = &ring[head & (TRACE_SIZE-1)];
+		record->cycles = profile_cycles();
+		record->event = event;
+		record->arg = arg;
+		head++;
+	}
+
+	__enable_irq();
+}
+
+/**
+ * @brief Start or stop recording, what's
+ *        in the ring is kept either way.
+ *
+ * @param on 1 to record, 0 not to
+ *
+ * @retval None
+ */
+void trace_setEnabled(int on)
+{
+	__disable_irq();
+	// no ring if it couldn't be had
+	enabled = on && ring != NULL;
+	__enable_irq();
+}
+
+/**
+ * @brief Ask for a dump, the telemetry task
+ *        does it in trace_service().
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_requestDump(void)
+{
+	dump_requested = 1;
+	task_signal(TASK_TELEMETRY);
+}
+
+/**
+ * @brief Dump the ring if one was asked for,
+ *        call this from a low priority task.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_service(void)
+{
+	if(!dump_requested)
+		return;
+
+	dump_requested = 0;
+	trace_dump();
+}
+
+/**
+ * @brief Print the ring oldest first, with the
+ *        event names and the clock. Recording
+ *        stops while it prints.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_dump(void)
+{
+	uint32_t first;
+	uint32_t last;
+	int was;
+
+	__disable_irq();
+	was = enabled;
+	enabled = 0;
+	last = head;
+	__enable_irq();
+
+	first = (last > TRACE_SIZE) ? last - TRACE_SIZE : 0;
+
+	// the names first so the converter
+	// doesn't need its own copy of the list
+	printf("trace begin\r\n");
+	printf("clock %lu\r\n", (unsigned long)SystemCoreClock);
+	for(int i = 0; i < TRACE_EVENT_NUM; i++)
+		printf("event %d %c %s|%s\r\n", i, trace_kinds[trace_info[i].kind], trace_info[i].track, trace_info[i].name);
+
+	for(uint32_t i = first; i < last; i++)
+	{
+		const TraceRecord* record = &ring[i & (TRACE_SIZE-1)];
+		printf("%08lx %02x %04x\r\n", (unsigned long)record->cycles, record->event, record->arg);
+	}
+
+	printf("trace end %lu lost\r\n", (unsigned long)first);
+
+	trace_setEnabled(was);
+}
@@ -0,0 +1,150 @@
+/**
+ * ========================
+ * File: trace.h
+ *
+ * Author: Joseph Kenyon
+ *
+ * Desc: Trace ring for glitch
+ * hunting. Blocks, DMA
+ * interrupts, UI ticks, touches,
+ * LCD draws and codec writes
+ * each put a record with a cycle
+ * time in a ring in DTCM, and
+ * the oldest are written over.
+ * A dump prints the ring as text
+ * over the UART, or to stdout on
+ * the host, and
+ * tools/trace_json.py turns that
+ * into Chrome/Perfetto trace JSON.
+ *
+ * Last Updated: 16/10/2026
+ *
+ * ========================
+**/
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include "main.h"
+#include "arena.h"
+#include "profile.h"
+
+// records the ring holds, a power of 2.
+// 8 bytes each, a block is about four
+#define TRACE_SIZE 1024
+
+/**
+ * @brief How a trace viewer should show
+ *        an event, a span is a begin and
+ *        an end on the same track
+ */
+typedef enum
+{
+	TRACE_BEGIN = 0,
+	TRACE_END,
+	TRACE_INSTANT,
+}TraceKind;
+
+// X(NAME, name, kind, track), arg is what the
+// event records alongside its time
+#define TRACE_LIST(X) \
+	X(BLOCK_START,      "block",       TRACE_BEGIN,   "audio") /* arg is the half */ \
+	X(BLOCK_END,        "block",       TRACE_END,     "audio") \
+	X(VOLUME_START,     "volume i2c",  TRACE_BEGIN,   "audio") /* arg is the volume */ \
+	X(VOLUME_END,       "volume i2c",  TRACE_END,     "audio") \
+	X(OVERRUN,          "overrun",     TRACE_INSTANT, "audio") \
+	X(UNDERRUN,         "underrun",    TRACE_INSTANT, "audio") \
+	X(DMA_HALF,         "dma half",    TRACE_INSTANT, "dma")   \
+	X(DMA_FULL,         "dma full",    TRACE_INSTANT, "dma")   \
+	X(TICK,             "tick",        TRACE_INSTANT, "ui")    \
+	X(TOUCH_READ_START, "touch i2c",   TRACE_BEGIN,   "ui")    \
+	X(TOUCH_READ_END,   "touch i2c",   TRACE_END,     "ui")    \
+	X(TOUCH_START,      "touch",       TRACE_BEGIN,   "ui")    /* arg is x */ \
+	X(TOUCH_END,        "touch",       TRACE_END,     "ui")    \
+	X(DRAW_START,       "draw",        TRACE_BEGIN,   "ui")    /* arg is the window */ \
+	X(DRAW_END,         "draw",        TRACE_END,     "ui")
+
+/**
+ * @brief Events that can be traced
+ */
+typedef enum
+{
+#define TRACE_EVENT_ENUM(NAME, name, kind, track) TRACE_##NAME,
+	TRACE_LIST(TRACE_EVENT_ENUM)
+#undef TRACE_EVENT_ENUM
+	TRACE_EVENT_NUM
+}TraceEvent;
+
+/**
+ * @brief One record in the ring
+ */
+typedef struct
+{
+	uint32_t cycles;  // from profile_cycles()
+	uint16_t event;   // TraceEvent
+	uint16_t arg;
+}TraceRecord;
+
+/**
+ * @brief Take the ring from DTCM and start
+ *        tracing. Nothing is recorded until
+ *        this is called.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_init(void);
+
+/**
+ * @brief Record an event, safe to call
+ *        from an interrupt.
+ *
+ * @param event The event
+ * @param arg Anything to go with it
+ *
+ * @retval None
+ */
+void trace_event(TraceEvent event, uint16_t arg);
+
+/**
+ * @brief Start or stop recording, what's
+ *        in the ring is kept either way.
+ *
+ * @param on 1 to record, 0 not to
+ *
+ * @retval None
+ */
+void trace_setEnabled(int on);
+
+/**
+ * @brief Ask for a dump, the telemetry task
+ *        does it in trace_service().
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_requestDump(void);
+
+/**
+ * @brief Dump the ring if one was asked for,
+ *        call this from a low priority task.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_service(void);
+
+/**
+ * @brief Print the ring oldest first, with the
+ *        event names and the clock. Recording
+ *        stops while it prints.
+ *
+ * @param None
+ *
+ * @retval None
+ */
+void trace_dump(void);
+
+#endif
@@ -10,13 +10,16 @@
  * located. And the global
  * tremolo struct. Tremolo is 
  * the modulation of volume 
- * using an LFO.
+ * using an LFO. Spread moves
+ * the right channel's LFO ahead
+ * of the left so a mono input
+ * comes out stereo.
  * ----------------
  * Equation used for tremolo
  * y(n) = x(n) * (lfoDepth * lfo(n))
  * ----------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -25,39 +28,106 @@
 // setup parameters
 #define TREMDEPTHIDX 0
 #define TREMRATEIDX  1
-static float parameterValues[2];
-static Parameter paramDepth = {"Depth[%]", 10.f, 0.0f, 100.f};
-static Parameter paramRate  = {"Rate[Hz]", 0.5f, 1.0f,  7.0f};
-static Parameter parameters[2];
-Effect tremolo;
+#define TREMSPREADIDX 2
+static Parameter paramDepth  = {"Depth[%]", 10.f, 0.0f, 100.f};
+static Parameter paramRate   = {"Rate[Hz]", 0.5f, 1.0f,  7.0f};
+static Parameter paramSpread = {"Spread[deg]", 15.0f, 0.0f, 180.0f};
+static Parameter parameters[3];
 
 /*
  *
- * @brief This function intialized the global 
- *        tremolo struct, this must be called 
- *        before usage.
+ * @brief Set up a new tremolo in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @param None
- * @retval None
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
  *
  */
-void tremolo_init(void)
+int tremolo_create(Effect* effect)
 {
+	// an lfo phase and its step, the right
+	// channel is a spread ahead of the left
+	TremoloState* s = arena_alloc(ARENA_DTCM, sizeof(TremoloState), ARENA_ALIGN);
+	float* values = arena_alloc(ARENA_SRAM1, 3*sizeof(float), ARENA_ALIGN);
+	if(s == NULL || values == NULL)
+		return -1;
+
 	// init params
 	parameters[TREMDEPTHIDX] = paramDepth;
 	parameters[TREMRATEIDX] = paramRate;
+	parameters[TREMSPREADIDX] = paramSpread;
+
+	values[TREMDEPTHIDX] = 50.f;
+	values[TREMRATEIDX] = 5.0f;
+	values[TREMSPREADIDX] = 0.0f;
 
-	parameterValues[TREMDEPTHIDX] = 50.f;
-	parameterValues[TREMRATEIDX] = 5.0f;
+	// init state
+	s->params = effect->audioValues;
+	s->phase = 0;
 
 	// init effect object
-	strcpy( tremolo.name, "Tremolo" );
-	tremolo.on = 0;
-	tremolo.currentParam = 0;
-	tremolo.paramNum = 2;
-	tremolo.parameters = parameters;
-	tremolo.processBuffer = tremolo_processBuffer;
-	tremolo.paramValues = parameterValues;
+	strcpy( effect->name, "Tremolo" );
+	effect->on = 0;
+	effect->currentParam = 0;
+	effect->paramNum = 3;
+	effect->parameters = parameters;
+	effect->prepare = tremolo_prepare;
+	effect->reset = tremolo_reset;
+	effect->type = EFFECT_TREMOLO;
+	effect->processBuffer = tremolo_processBuffer;
+	effect->paramValues = values;
+	effect->state = s;
+
+	// audio loop picks these up before the first block
+	mailbox_init(&effect->mailbox);
+	effect_postParams(effect);
+
+	return 0;
+}
+
+/*
+ *
+ * @brief Work out the lfo step and depth from
+ *        the parameters. Called by the engine
+ *        when the parameters change.
+ * 
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ * @retval None
+ *
+ */
+void tremolo_prepare(void* state, uint32_t sampleRate)
+{
+	TremoloState* s = (TremoloState*)state;
+
+#if AUDIO_FIXED_POINT
+	s->phaseStep = dsp_phase_step(s->params[TREMRATEIDX], sampleRate);
+	s->spread = (uint32_t)((s->params[TREMSPREADIDX] / 360.0f) * 4294967296.0f);
+	s->lfoDepth = dsp_float_to_q15(s->params[TREMDEPTHIDX]/100.0f);
+#else
+	s->phaseStep = s->params[TREMRATEIDX] / sampleRate;
+	s->spread = s->params[TREMSPREADIDX] / 360.0f;
+	s->lfoDepth = (s->params[TREMDEPTHIDX]/100.0f);
+#endif
+}
+
+/*
+ *
+ * @brief Start the lfo from the top again.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
+ *
+ * @retval None
+ *
+ */
+void tremolo_reset(void* state)
+{
+	TremoloState* s = (TremoloState*)state;
+
+	s->phase = 0;
 }
 
 /*
@@ -65,34 +135,23 @@ void tremolo_init(void)
  * @brief This function will perfrom the tremolo effect
  *        on the data passed in.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffer
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void tremolo_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset)
+AUDIO_ITCM void tremolo_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames)
 {
-	if(tremolo.on)
-	{
-		static float phase = 0;
-		float lfoFreq = parameterValues[TREMRATEIDX];
-		float lfoDepth = (parameterValues[TREMDEPTHIDX]/100.0f);
-
-		for(int i = offset; i < offset+(AUDIO_BLOCK_SIZE/2); i++)
-		{
-			// get current sample
-			int16_t sample = (int16_t) outputData[i];
-
-			// modulate sample volume with lfo
-			sample *= (1.0-lfoDepth) + lfoDepth * arm_cos_f32(2*PI*phase);
-
-			// send to output
-			outputData[i] = (uint16_t) sample;
-
-			// update phase
-			phase =  fmodf(phase + lfoFreq / 44100,1);
-		}
-	}
+	TremoloState* s = (TremoloState*)state;
+
+	// copy so the coefficients stay in registers
+	TremoloState t = *s;
+
+	for(uint32_t i = 0; i < frames; i++)
+		outputData[i] = tremolo_frame(&t, &t.phase, inputData[i]);
+
+	s->phase = t.phase;
 }
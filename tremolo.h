@@ -7,8 +7,8 @@
  * Desc: The tremolo effect,
  * this is where all the
  * function definitions are
- * located. And the global
- * tremolo struct. Tremolo is 
+ * located. And the state
+ * for each tremolo. Tremolo is 
  * the modulation of volume 
  * using an LFO.
  * ----------------
@@ -16,7 +16,7 @@
  * y(n) = x(n) * (lfoDepth * lfo(n))
  * ----------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -28,32 +28,125 @@
 #include "arm_common_tables.h"
 #include "effect.h"
 
+/**
+ * @brief State for a tremolo
+ */
+typedef struct
+{
+	const float* params;
+#if AUDIO_FIXED_POINT
+	uint32_t phase; // a full turn is 2^32
+#else
+	float phase;
+#endif
 
-extern Effect tremolo; // global tremolo object
+	// worked out by tremolo_prepare()
+#if AUDIO_FIXED_POINT
+	uint32_t phaseStep;
+	uint32_t spread; // right lfo is this far ahead
+	q15_t lfoDepth;
+#else
+	float phaseStep;
+	float spread;    // right lfo is this far ahead
+	float lfoDepth;
+#endif
+}TremoloState;
 
 /*
+ *
+ * @brief Set up a new tremolo in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
+ *
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
+ *
+ */
+int tremolo_create(Effect* effect);
+
+/*
+ *
+ * @brief Work out the lfo step and depth from
+ *        the parameters. Called by the engine
+ *        when the parameters change.
  * 
- * @brief This function intialized the global tremolo
- *        struct, this must be called before usage.
- * 
- * @param None
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
  * @retval None
- * 
+ *
  */
-void  tremolo_init(void);
+void tremolo_prepare(void* state, uint32_t sampleRate);
+
+/*
+ *
+ * @brief Start the lfo from the top again.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
+ *
+ * @retval None
+ *
+ */
+void tremolo_reset(void* state);
 
 /*
  *
  * @brief This function will perfrom the tremolo effect
  *        on the data passed in.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffer
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  * 
  * @retval None
  *
  */
-void  tremolo_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset);
+void  tremolo_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames);
+
+/*
+ *
+ * @brief Tremolo on one frame, the block kernel
+ *        and the fused kernels are built from this.
+ *
+ * @param s The effects state
+ * @param phase The lfo phase, moved on a frame
+ * @param x The frame
+ *
+ * @retval The output frame
+ *
+ */
+static inline frame_t tremolo_frame(const TremoloState* s, phase_t* phase, frame_t x)
+{
+#if AUDIO_FIXED_POINT
+	// volume is (1-depth) + depth*lfo, 1.0
+	// is just out of Q15 so it saturates
+	q15_t left = dsp_sat_q15(32768 - s->lfoDepth + dsp_mul_q15(s->lfoDepth, dsp_cos_q15(*phase)));
+	q15_t right = left;
+	if(s->spread)
+		right = dsp_sat_q15(32768 - s->lfoDepth + dsp_mul_q15(s->lfoDepth, dsp_cos_q15(*phase + s->spread)));
+
+	// update phase, wraps by itself
+	*phase += s->phaseStep;
+
+	// modulate frame volume with lfo
+	return dsp_mul2(x, dsp_pack(left, right));
+#else
+	// volume for each channel
+	float left = (1.0f-s->lfoDepth) + s->lfoDepth * arm_cos_f32(2*PI*(*phase));
+	float right = left;
+	if(s->spread)
+		right = (1.0f-s->lfoDepth) + s->lfoDepth * arm_cos_f32(2*PI*(*phase + s->spread));
+
+	// update phase
+	*phase = fmodf(*phase + s->phaseStep, 1);
+
+	// modulate frame volume with lfo
+	x.l *= left;
+	x.r *= right;
+	return x;
+#endif
+}
 
 #endif
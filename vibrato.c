@@ -16,85 +16,181 @@
  * y(n) = x(n-(1+(maxDelay*abs(lfoDepth*lfo(n))))
  * ------------------
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
 #include "vibrato.h"
 
 // setup parameters used
-static float parameterValues[3];
 static Parameter paramRate  = {"Rate[Hz] ",  1.0f, 4.0f,  15.0f}; // 0 to 1 hz
 static Parameter paramDepth = {"Depth[%] ", 10.0f, 0.0f,  100.0f}; // 0 to 100 %
 static Parameter paramDelay = {"Delay[ms]",  1.0f, 4.0f,  10.0f}; // 0 to 15ms
 static Parameter parameters[3];
-Effect vibrato;
 
 /**
  *
- * @brief This function intialized the global
- *        vibrato struct, this must be called
- *        before usage.
+ * @brief Set up a new vibrato in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @param None
+ * @param effect The effect object to set up
  *
- * @retval None
+ * @retval 0 on success, -1 if an arena is out of budget
  *
  */
-void vibrato_init(void)
+int vibrato_create(Effect* effect)
 {
+	// its delay tops out at 10ms, 960 frames
+	// at 96kHz, which SRAM1 holds
+	frame_t* buffer = arena_alloc(ARENA_SRAM1, VIBRATO_LINE_SIZE*sizeof(frame_t), ARENA_ALIGN_CACHE);
+	if(buffer == NULL)
+		return -1;
+
+	// the sweep is worked out every frame
+	// from the phase and depth held here
+	VibratoState* s = arena_alloc(ARENA_DTCM, sizeof(VibratoState), ARENA_ALIGN);
+	float* values = arena_alloc(ARENA_SRAM1, 3*sizeof(float), ARENA_ALIGN);
+	if(s == NULL || values == NULL)
+		return -1;
+
 	// init params
 	parameters[0] = paramRate;
 	parameters[1] = paramDepth;
 	parameters[2] = paramDelay;
 
-	parameterValues[0] = 5.0f;
-	parameterValues[1] = 50.0f;
-	parameterValues[2] = 5.0f;
+	values[0] = 5.0f;
+	values[1] = 50.0f;
+	values[2] = 5.0f;
+
+	// init state
+	s->params = effect->audioValues;
+	s->phase = 0;
+	delayline_init(&s->line, buffer, VIBRATO_LINE_SIZE);
 
 	// init effect object
-	strcpy( vibrato.name, "VIBRATO" );
-	vibrato.on = 0;
-	vibrato.currentParam = 0;
-	vibrato.paramNum = 3;
-	vibrato.parameters = parameters;
-	vibrato.processBuffer = vibrato_processBuffer;
-	vibrato.paramValues = parameterValues;
+	strcpy( effect->name, "VIBRATO" );
+	effect->on = 0;
+	effect->currentParam = 0;
+	effect->paramNum = 3;
+	effect->parameters = parameters;
+	effect->prepare = vibrato_prepare;
+	effect->reset = vibrato_reset;
+	effect->type = EFFECT_VIBRATO;
+	effect->processBuffer = vibrato_processBuffer;
+	effect->paramValues = values;
+	effect->state = s;
+
+	// audio loop picks these up before the first block
+	mailbox_init(&effect->mailbox);
+	effect_postParams(effect);
+
+	return 0;
+}
+
+/**
+ * @brief Work out the delay range and lfo
+ *        step from the parameters. Called by
+ *        the engine when the parameters change.
+ *
+ * @param state The effects state
+ * @param sampleRate Sample rate to work them out for
+ *
+ * @retval None
+ *
+ */
+void vibrato_prepare(void* state, uint32_t sampleRate)
+{
+	VibratoState* s = (VibratoState*)state;
+
+	s->maxDelay = ((s->params[2])*sampleRate)/1000;
+
+#if AUDIO_FIXED_POINT
+	s->phaseStep = dsp_phase_step(s->params[0], sampleRate);
+	s->lfoDepth = dsp_float_to_q15(s->params[1]/100.0f);
+#else
+	s->phaseStep = s->params[0] / sampleRate;
+	s->lfoDepth = (s->params[1]/100.0f);
+#endif
+}
+
+/**
+ * @brief Clear the line and lfo phase so the
+ *        vibrato starts from silence.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
+ *
+ * @retval None
+ *
+ */
+void vibrato_reset(void* state)
+{
+	VibratoState* s = (VibratoState*)state;
+
+	delayline_clear(&s->line);
+	s->phase = 0;
 }
 
 /**
  * @brief This function applies the vibrato effect
  *        to the input buffer.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void vibrato_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset)
+AUDIO_ITCM void vibrato_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames)
 {
-	if(vibrato.on)
+	VibratoState* s = (VibratoState*)state;
+	uint16_t maxDelay = s->maxDelay;
+
+#if AUDIO_FIXED_POINT
+	uint32_t phase = s->phase;
+	uint32_t phaseStep = s->phaseStep;
+	q15_t lfoDepth = s->lfoDepth;
+
+	for(uint32_t i = 0; i < frames; i++)
 	{
-		static float phase = 0;
-		uint16_t maxDelay  = ((parameterValues[2])*44100)/1000;
-		float lfoFreq = parameterValues[0];
-		float lfoDepth = (parameterValues[1]/100.0f);
+		delayline_write(&s->line, inputData[i]);
+
+		// get the modulated delay, lfo is -1 to 1 so
+		// (1 - lfo) is 0 to 2, 0 to 65536 in Q15. that's
+		// past a q15_t so it's kept in an int32_t, and
+		// maxDelay/2 is under 32768 so the product stays
+		// under 2^31
+		int32_t sweep = 32768 - dsp_mul_q15(lfoDepth, dsp_cos_q15(phase));
+		uint16_t delaySamples = (uint16_t)(1 + (((maxDelay/2) * sweep) >> 15));
+
+		// send the delayed frame to output
+		outputData[i] = delayline_read(&s->line, delaySamples);
 
-		for(int i = offset; i < offset+(AUDIO_BLOCK_SIZE/2); i++)
-		{
-			// get the modulated delay
-			uint16_t delaySamples = (uint16_t)(1+(maxDelay/2)*(1-(lfoDepth * arm_cos_f32(2*PI*phase))));
+		// update phase, wraps by itself
+		phase += phaseStep;
+	}
+#else
+	float phase = s->phase;
+	float phaseStep = s->phaseStep;
+	float lfoDepth = s->lfoDepth;
+
+	for(uint32_t i = 0; i < frames; i++)
+	{
+		delayline_write(&s->line, inputData[i]);
 
-			// get the delayed sample
-			int16_t prevSample = (int16_t)inputData[(i + AUDIO_BUFFER_SIZE - delaySamples) % AUDIO_BUFFER_SIZE];
+		// get the modulated delay
+		uint16_t delaySamples = (uint16_t)(1+(maxDelay/2)*(1-(lfoDepth * arm_cos_f32(2*PI*phase))));
 
-			// send to output
-			outputData[i] = (uint16_t) prevSample;
+		// send the delayed frame to output
+		outputData[i] = delayline_read(&s->line, delaySamples);
 
-			// update phase
-			phase =  fmodf(phase + lfoFreq / 44100,1);
-		}
+		// update phase
+		phase =  fmodf(phase + phaseStep,1);
 	}
+#endif
+
+	s->phase = phase;
 }
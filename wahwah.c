@@ -18,7 +18,7 @@
  * H(s) = (s/Q) / (s^2 + s/Q + 1)
  * 
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -28,18 +28,10 @@
 #define WAHWAH_CENTRE_IDX  0
 #define WAHWAH_RATE_IDX    1
 #define WAHWAH_DEPTH_IDX   2
-static float parameterValues[3];
 static Parameter paramDepth       = {"Depth[%]       ", 10.f, 0.0f, 100.f};
 static Parameter paramRate        = {"Rate[Hz]       ", 1.0f, 1.0f,  10.0f};
 static Parameter paramCentreFreq  = {"Cutoff[Hz]", 100.0f, 100.0f,  4000.0f}; // 100 to 4000 hz
 static Parameter parameters[3];
-Effect wahwah;
-
-// bandpass filter coeff's.
-static float bp_a0, bp_a1, bp_a2, bp_b0, bp_b1, bp_b2;
-
-// bandpass previous samples.
-static float bp_x1, bp_x2, bp_y1, bp_y2;
 
 /**
  *
@@ -51,141 +43,165 @@ static float bp_x1, bp_x2, bp_y1, bp_y2;
  * CutOff value determines the cutoff
  * frequency of the filter.
  */
-static float currentCutoff = 440.0f;
-static float qFactor = 2.3f;
+static const float initialCutoff = 440.0f;
+static const float qFactor = 2.3f;
 
 /**
  *
- * @brief This function updates the bandpass
- *        filters coeffiants
+ * @brief This function works out bandpass
+ *        filter coeffiants, they are divided
+ *        by a0 (and stored in Q30 for fixed point)
  * 
  *        Transer function for coefficents
  *        H(s) = (s/Q) / (s^2 + s/Q + 1)
  *
- * @param None
+ * @param c Where to put the coefficients
+ * @param cutoff The cutoff frequency
+ * @param sampleRate The sample rate
  * @retval None
  *
  */
-static void new_bandpass()
+static void new_bandpass(WahWahCoeffs* c, float cutoff, uint32_t sampleRate)
 {
-    float omega = 2 * PI * currentCutoff / 44100;
+    float omega = 2 * PI * cutoff / sampleRate;
     float cosomega = arm_cos_f32(omega);
     float alpha = arm_sin_f32(omega) / (2 * qFactor);
-
-    bp_b0 = alpha;
-    bp_b1 = 0;
-    bp_b2 = -alpha;
-    bp_a0 = 1 + alpha;
-    bp_a1 = -2 * cosomega;
-    bp_a2 = 1 - alpha;
+    float a0 = 1 + alpha;
+
+#if AUDIO_FIXED_POINT
+    c->b0 = (int32_t)((alpha / a0) * 1073741824.0f);
+    c->a1 = (int32_t)((-2 * cosomega / a0) * 1073741824.0f);
+    c->a2 = (int32_t)(((1 - alpha) / a0) * 1073741824.0f);
+#else
+    c->b0 = alpha / a0;
+    c->a1 = -2 * cosomega / a0;
+    c->a2 = (1 - alpha) / a0;
+#endif
 }
 
 /**
  *
- * @brief This function applies a bandpass 
- *        filter to an input sample.
- *  
+ * @brief Set up a new wahwah in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @param inSample The sample to apply the filter to
- * @retval Returns the filtered sample
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
  *
  */
-static int16_t apply_bandpass(int16_t inSample)
+int wahwah_create(Effect* effect)
 {
-	float x0 = (float)inSample;
-	float result =
-		(bp_b0 / bp_a0) * x0 +
-		(bp_b1 / bp_a0) * bp_x1 +
-		(bp_b2 / bp_a0) * bp_x2 -
-		(bp_a1 / bp_a0) * bp_y1 -
-		(bp_a2 / bp_a0) * bp_y2;
-
-	// shift x1 to x2, sample to x1
-	// shift y1 to y2, result to y1
-	// simulate delay!!
-	bp_x2 = bp_x1;
-	bp_x1 = x0;
-	bp_y2 = bp_y1;
-	bp_y1 = result;
-
-	return (int16_t)result;
+	// the coefficient table is most of it,
+	// the kernel reads from it every frame
+	WahWahState* s = arena_alloc(ARENA_DTCM, sizeof(WahWahState), ARENA_ALIGN);
+	float* values = arena_alloc(ARENA_SRAM1, 3*sizeof(float), ARENA_ALIGN);
+	if(s == NULL || values == NULL)
+		return -1;
+
+	// init params
+	parameters[WAHWAH_CENTRE_IDX] = paramCentreFreq;
+	parameters[WAHWAH_RATE_IDX] = paramRate;
+	parameters[WAHWAH_DEPTH_IDX] = paramDepth;
+
+	values[WAHWAH_CENTRE_IDX] = 550.0f;
+	values[WAHWAH_RATE_IDX]   = 4.0f;
+	values[WAHWAH_DEPTH_IDX]  = 70.0f;
+
+	// init state, flat filter until prepared
+	memset(s, 0, sizeof(*s));
+	s->params = effect->audioValues;
+	for(int i = 0; i <= WAHWAH_TABLE_SIZE; i++)
+		new_bandpass(&s->table[i], initialCutoff, AUDIO_SAMPLE_RATE_DEFAULT);
+
+	// init effect object
+	strcpy( effect->name, "WahWah" );
+	effect->on = 0;
+	effect->currentParam = 0;
+	effect->paramNum = 3;
+	effect->parameters = parameters;
+	effect->prepare = wahwah_prepare;
+	effect->reset = wahwah_reset;
+	effect->type = EFFECT_WAHWAH;
+	effect->processBuffer = wahwah_processBuffer;
+	effect->paramValues = values;
+	effect->state = s;
+
+	// audio loop picks these up before the first block
+	mailbox_init(&effect->mailbox);
+	effect_postParams(effect);
+
+	return 0;
 }
 
 /**
  *
- * @brief This function intializes the global
- *        wahwah struct, this must be called
- *        before usage.
+ * @brief  Work out the filter coefficients across
+ *         the lfo sweep. Called by the engine when
+ *         the parameters change.
  *
- * @param None
+ * @param  state The effects state
+ * @param  sampleRate Sample rate to work them out for
  * @retval None
  *
  */
-void wahwah_init(void)
+void wahwah_prepare(void* state, uint32_t sampleRate)
 {
-	// init params
-	parameters[WAHWAH_CENTRE_IDX] = paramCentreFreq;
-	parameters[WAHWAH_RATE_IDX] = paramRate;
-	parameters[WAHWAH_DEPTH_IDX] = paramDepth;
+	WahWahState* s = (WahWahState*)state;
+	float lfoFreq = s->params[WAHWAH_RATE_IDX];
+	float lfoDepth = s->params[WAHWAH_DEPTH_IDX]/100.0f;
+	float centreFreq = s->params[WAHWAH_CENTRE_IDX];
 
-	parameterValues[WAHWAH_CENTRE_IDX] = 550.0f;
-	parameterValues[WAHWAH_RATE_IDX]   = 4.0f;
-	parameterValues[WAHWAH_DEPTH_IDX]  = 70.0f;
+	// lfo goes -1 to 1 across the table
+	for(int i = 0; i <= WAHWAH_TABLE_SIZE; i++)
+	{
+		float lfoSample = -1.0f + (2.0f * i) / WAHWAH_TABLE_SIZE;
+		new_bandpass(&s->table[i], (lfoSample * lfoDepth * centreFreq) + centreFreq, sampleRate);
+	}
 
-	// init effect object
-	strcpy( wahwah.name, "WahWah" );
-	wahwah.on = 0;
-	wahwah.currentParam = 0;
-	wahwah.paramNum = 3;
-	wahwah.parameters = parameters;
-	wahwah.processBuffer = wahwah_processBuffer;
-	wahwah.paramValues = parameterValues;
-
-	new_bandpass();
+#if AUDIO_FIXED_POINT
+	s->phaseStep = dsp_phase_step(lfoFreq, sampleRate);
+#else
+	s->phaseStep = lfoFreq / sampleRate;
+#endif
+}
+
+/**
+ * @brief Clear the filter history and lfo
+ *        phase, the coefficient table is kept.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
+ *
+ * @retval None
+ *
+ */
+void wahwah_reset(void* state)
+{
+	WahWahState* s = (WahWahState*)state;
+
+	memset(&s->voice, 0, sizeof(s->voice));
 }
 
 /**
  * @brief This function applies the delay effect
  *        to the input buffer.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void wahwah_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset)
+AUDIO_ITCM void wahwah_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames)
 {
-	if(wahwah.on)
-	{
-		static float phase = 0;
-		float lfoFreq = parameterValues[WAHWAH_RATE_IDX];
-		float lfoDepth = parameterValues[WAHWAH_DEPTH_IDX]/100.0f;
-		float centreFreq = parameterValues[WAHWAH_CENTRE_IDX];
-
-		for(int i = offset; i < offset+(AUDIO_BLOCK_SIZE/2); i++)
-		{
-			// update phase
-			phase = fmodf((phase + lfoFreq / 44100), 1);
-
-			// get triangle lfo sample 
-			float lfoSample = phase < 0.5 ? phase * 4 - 1 : 3 - 4 * phase;
+	WahWahState* s = (WahWahState*)state;
+	WahWahVoice v = s->voice;
 
-			// modulate bandpass cutoff
-			currentCutoff = (float)((lfoSample * lfoDepth * centreFreq) + centreFreq);
+	for(uint32_t i = 0; i < frames; i++)
+		outputData[i] = wahwah_frame(s, &v, inputData[i]);
 
-			// update bandpass filter
-			new_bandpass();
-
-			// get current sample
-			int16_t sample = (int16_t) outputData[i];
-
-			// apply bandpass filter to current sample
-			sample = apply_bandpass(sample);
-
-			// send to output
-			outputData[i] = (uint16_t) (sample);
-		}
-	}
+	s->voice = v;
 }
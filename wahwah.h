@@ -18,7 +18,7 @@
  * H(s) = (s/Q) / (s^2 + s/Q + 1)
  *
  *
- * Last Updated: 16/05/2021
+ * Last Updated: 16/10/2026
  *
  * ========================
 **/
@@ -30,32 +30,253 @@
 #include "arm_common_tables.h"
 #include "effect.h"
 
-// global wahwah object
-extern Effect wahwah; 
+// filter coefficients are worked out at this many
+// points across the lfo sweep, and interpolated
+#define WAHWAH_TABLE_SIZE 64
 
 /**
+ * @brief Bandpass coefficients, divided
+ *        by a0. b1 is 0 and b2 is -b0.
+ */
+typedef struct
+{
+#if AUDIO_FIXED_POINT
+	int32_t b0, a1, a2; // Q30
+#else
+	float b0, a1, a2;
+#endif
+}WahWahCoeffs;
+
+/**
+ * @brief Previous samples of the
+ *        bandpass filter, one per channel
+ */
+typedef struct
+{
+#if AUDIO_FIXED_POINT
+	int32_t x1, x2;        // Q15
+	int32_t y1, y2;        // Q15 with 14 more fraction bits
+#else
+	float x1, x2, y1, y2;
+#endif
+}WahWahHistory;
+
+/**
+ * @brief What moves on each frame, the lfo
+ *        phase and the filter history. Kernels
+ *        copy it for the block so it can stay
+ *        in registers.
+ */
+typedef struct
+{
+	phase_t phase;
+	WahWahHistory left;
+	WahWahHistory right;
+}WahWahVoice;
+
+/**
+ * @brief State for a wahwah, the
+ *        bandpass filter and its
+ *        previous samples
+ */
+typedef struct
+{
+	const float* params;
+	phase_t phaseStep;
+	WahWahVoice voice;
+
+	// worked out by wahwah_prepare(), from
+	// the bottom of the sweep to the top
+	WahWahCoeffs table[WAHWAH_TABLE_SIZE+1];
+}WahWahState;
+
+/**
+ *
+ * @brief Set up a new wahwah in effect, its
+ *        state comes from the arenas. Use
+ *        registry_create() rather than this.
  *
- * @brief  This function intialized the global
- *         wahwah struct, this must be called
- *         before usage.
+ * @param effect The effect object to set up
+ *
+ * @retval 0 on success, -1 if an arena is out of budget
+ *
+ */
+int wahwah_create(Effect* effect);
+
+/**
+ *
+ * @brief  Work out the filter coefficients across
+ *         the lfo sweep. Called by the engine when
+ *         the parameters change.
+ *
+ * @param  state The effects state
+ * @param  sampleRate Sample rate to work them out for
+ * @retval None
+ *
+ */
+void wahwah_prepare(void* state, uint32_t sampleRate);
+
+/**
+ * @brief Clear the filter history and lfo
+ *        phase, the coefficient table is kept.
+ *        Called before it is turned back on.
+ *
+ * @param state The effects state
  *
- * @param  None
  * @retval None
  *
  */
-void wahwah_init(void);
+void wahwah_reset(void* state);
 
 /**
  * @brief This function applies the delay effect
  *        to the input buffer.
  *
+ * @param state The effects state
  * @param inputData Pointer to the block of input data
- * @param outputData Pointer to the block of output data
- * @param offset The offset into the sample buffers
+ * @param outputData Pointer to the block of output data, can be inputData
+ * @param frames Number of frames in the block
  *
  * @retval None
  *
  */
-void wahwah_processBuffer(uint16_t* inputData, uint16_t* outputData, uint32_t offset);
+void wahwah_processBuffer(void* state, const frame_t* inputData, frame_t* outputData, uint32_t frames);
+
+#if AUDIO_FIXED_POINT
+/**
+ *
+ * @brief This function applies a bandpass 
+ *        filter to an input sample.
+ *  
+ *
+ * @param h The channels filter history
+ * @param c The filter coefficients
+ * @param inSample The sample to apply the filter to
+ * @retval Returns the filtered sample
+ *
+ */
+static inline q15_t wahwah_bandpass(WahWahHistory* h, const WahWahCoeffs* c, q15_t inSample)
+{
+	int32_t x0 = inSample;
+
+	// Q30 coefficients, 64 bit accumulator. the feedback
+	// keeps 14 extra bits, truncating it to Q15 is
+	// amplified by the resonance and is very audible
+	int64_t acc =
+		((int64_t)c->b0 * (x0 - h->x2) << 14) -
+		(int64_t)c->a1 * h->y1 -
+		(int64_t)c->a2 * h->y2;
+
+	int32_t y0 = (int32_t)(acc >> 30);
+
+	// keep the feedback in range
+	if(y0 > (1 << 29) - 1) y0 = (1 << 29) - 1;
+	if(y0 < -(1 << 29)) y0 = -(1 << 29);
+
+	// shift x1 to x2, sample to x1
+	// shift y1 to y2, result to y1
+	h->x2 = h->x1;
+	h->x1 = x0;
+	h->y2 = h->y1;
+	h->y1 = y0;
+
+	return dsp_sat_q15(y0 >> 14);
+}
+#else
+/**
+ *
+ * @brief This function applies a bandpass 
+ *        filter to an input sample.
+ *  
+ *
+ * @param h The channels filter history
+ * @param c The filter coefficients
+ * @param inSample The sample to apply the filter to
+ * @retval Returns the filtered sample
+ *
+ */
+static inline float32_t wahwah_bandpass(WahWahHistory* h, const WahWahCoeffs* c, float32_t inSample)
+{
+	float x0 = inSample;
+	float result =
+		c->b0 * (x0 - h->x2) -
+		c->a1 * h->y1 -
+		c->a2 * h->y2;
+
+	// shift x1 to x2, sample to x1
+	// shift y1 to y2, result to y1
+	// simulate delay!!
+	h->x2 = h->x1;
+	h->x1 = x0;
+	h->y2 = h->y1;
+	h->y1 = result;
+
+	return result;
+}
+#endif
+
+/**
+ *
+ * @brief Wahwah on one frame, the block kernel
+ *        and the fused kernels are built from this.
+ *
+ * @param s The effects state
+ * @param v The phase and history, moved on a frame
+ * @param x The frame
+ *
+ * @retval The output frame
+ *
+ */
+static inline frame_t wahwah_frame(const WahWahState* s, WahWahVoice* v, frame_t x)
+{
+	WahWahCoeffs c;
+	phase_t* phase = &v->phase;
+
+#if AUDIO_FIXED_POINT
+	// update phase, wraps by itself
+	*phase += s->phaseStep;
+
+	// triangle lfo, 0 at the bottom of the
+	// sweep up to 2^32 at the top
+	uint32_t sweep = (*phase < 0x80000000u) ? *phase << 1 : ~*phase << 1;
+
+	// interpolate the coefficients from the table
+	const WahWahCoeffs* lo = &s->table[sweep >> 26];
+	const WahWahCoeffs* hi = lo + 1;
+	int32_t frac = (sweep >> 11) & 0x7FFF;
+	c.b0 = lo->b0 + (int32_t)(((int64_t)(hi->b0 - lo->b0) * frac) >> 15);
+	c.a1 = lo->a1 + (int32_t)(((int64_t)(hi->a1 - lo->a1) * frac) >> 15);
+	c.a2 = lo->a2 + (int32_t)(((int64_t)(hi->a2 - lo->a2) * frac) >> 15);
+
+	// apply bandpass filter to both channels
+	return dsp_pack(
+			wahwah_bandpass(&v->left, &c, dsp_left(x)),
+			wahwah_bandpass(&v->right, &c, dsp_right(x)));
+#else
+	// update phase
+	*phase = fmodf((*phase + s->phaseStep), 1);
+
+	// get triangle lfo sample 
+	float lfoSample = *phase < 0.5 ? *phase * 4 - 1 : 3 - 4 * *phase;
+
+	// interpolate the coefficients from the table
+	float position = (lfoSample + 1) * (WAHWAH_TABLE_SIZE/2);
+	int index = (int)position;
+	if(index > WAHWAH_TABLE_SIZE-1)
+		index = WAHWAH_TABLE_SIZE-1;
+	float frac = position - index;
+
+	const WahWahCoeffs* lo = &s->table[index];
+	const WahWahCoeffs* hi = lo + 1;
+	c.b0 = lo->b0 + frac * (hi->b0 - lo->b0);
+	c.a1 = lo->a1 + frac * (hi->a1 - lo->a1);
+	c.a2 = lo->a2 + frac * (hi->a2 - lo->a2);
+
+	// apply bandpass filter to both channels
+	x.l = wahwah_bandpass(&v->left, &c, x.l);
+	x.r = wahwah_bandpass(&v->right, &c, x.r);
+	return x;
+#endif
+}
 
 #endif